@@ -0,0 +1,82 @@
+#include "allocstats.h"
+
+#ifdef ALLOC_TRACKING
+#include <cstdlib>
+#include <new>
+#endif
+
+// ------------------------------------------------------------------
+// Allocation hooks
+
+#ifdef ALLOC_TRACKING
+
+namespace {
+
+thread_local uint64_t allocationCounter = 0;
+
+void *countedAlloc(std::size_t size) {
+    ++allocationCounter;
+    return std::malloc(size ? size : 1);
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (void *p = countedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    if (void *p = countedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+bool allocationTrackingEnabled() {
+    return true;
+}
+
+uint64_t threadAllocationCount() {
+    return allocationCounter;
+}
+
+#else
+
+bool allocationTrackingEnabled() {
+    return false;
+}
+
+uint64_t threadAllocationCount() {
+    return 0;
+}
+
+#endif
+
+// ------------------------------------------------------------------
+// AllocationScope Implementation
+
+AllocationScope::AllocationScope()
+    : start(threadAllocationCount())
+{
+}
+
+uint64_t AllocationScope::allocations() const
+{
+    return threadAllocationCount() - start;
+}
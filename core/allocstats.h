@@ -0,0 +1,27 @@
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+
+// Heap allocation accounting for hot paths such as the AI search. Building
+// with ALLOC_TRACKING defined (qmake: CONFIG += alloc_tracking) replaces the
+// global operator new and counts every allocation on the thread making it.
+// Without it the counters stay at zero and cost nothing.
+
+#include <cstdint>
+
+bool allocationTrackingEnabled();
+// Allocations made so far by the calling thread.
+uint64_t threadAllocationCount();
+
+// --- AllocationScope Class Definition ---
+// Counts the allocations the current thread makes during its lifetime.
+class AllocationScope
+{
+public:
+    AllocationScope();
+    uint64_t allocations() const;
+
+private:
+    uint64_t start;
+};
+
+#endif // ALLOCSTATS_H
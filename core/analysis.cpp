@@ -0,0 +1,130 @@
+#include "analysis.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// ------------------------------------------------------------------
+// Helper functions
+
+// Value of the position for player when 'toMove' is the next to play.
+static int positionValue(BoardState &board, char toMove, char player) {
+    int score = evalMinimax(board, toMove); // positive favours 'O'
+    int value = (score > 0) ? 1 : (score < 0) ? -1 : 0;
+    return (player == 'O') ? value : -value;
+}
+
+static char valueChar(int value) {
+    return (value > 0) ? 'W' : (value < 0) ? 'L' : 'D';
+}
+
+static bool charValue(char c, int &value) {
+    switch (c) {
+    case 'W': value = 1; return true;
+    case 'D': value = 0; return true;
+    case 'L': value = -1; return true;
+    default: return false;
+    }
+}
+
+// ------------------------------------------------------------------
+// Analysis
+
+bool analyseGame(const GameRecord &record, std::vector<MoveEvaluation> &evaluations) {
+    evaluations.clear();
+    if (isUltimateRecord(record))
+        return false;
+    BoardState board = emptyBoard();
+    int valueBefore = 0;
+    bool haveValue = false;
+    char toMove = 'X';
+
+    for (const Move &m : record.moves) {
+        // X opens and the players alternate; anything else is a damaged line.
+        if (m.row < 0 || m.row >= 3 || m.col < 0 || m.col >= 3 || board[m.row][m.col] != ' ' || m.player != toMove)
+            return false;
+        if (evalIsWinner(board, 'X') || evalIsWinner(board, 'O'))
+            return false;
+
+        const char opponent = (m.player == 'X') ? 'O' : 'X';
+        // The value after the previous move, seen from this mover's side.
+        if (!haveValue)
+            valueBefore = positionValue(board, m.player, m.player);
+
+        board[m.row][m.col] = m.player;
+        MoveEvaluation evaluation;
+        evaluation.before = valueBefore;
+        evaluation.after = positionValue(board, opponent, m.player);
+        evaluations.push_back(evaluation);
+
+        valueBefore = -evaluation.after;
+        haveValue = true;
+        toMove = opponent;
+    }
+    return true;
+}
+
+MoveVerdict moveVerdict(const MoveEvaluation &evaluation) {
+    if (evaluation.after >= evaluation.before)
+        return VERDICT_GOOD;
+    return (evaluation.before > 0) ? VERDICT_MISSED_WIN : VERDICT_BLUNDER;
+}
+
+const char *valueName(int value) {
+    return (value > 0) ? "win" : (value < 0) ? "loss" : "draw";
+}
+
+uint64_t gameRecordKey(const GameRecord &record) {
+    // 64-bit FNV-1a over the history line.
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : encodeGameRecord(record)) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// ------------------------------------------------------------------
+// Cache format
+
+std::string encodeAnalysis(uint64_t key, const std::vector<MoveEvaluation> &evaluations) {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(key));
+    std::string line = std::string(hex) + "|";
+    for (size_t i = 0; i < evaluations.size(); ++i) {
+        line += valueChar(evaluations[i].before);
+        line += valueChar(evaluations[i].after);
+        if (i < evaluations.size() - 1)
+            line += ";";
+    }
+    return line;
+}
+
+bool decodeAnalysis(const std::string &line, uint64_t &key, std::vector<MoveEvaluation> &evaluations) {
+    evaluations.clear();
+    size_t bar = line.find('|');
+    if (bar != 16)
+        return false;
+    // Exactly the 16 lowercase hex digits encodeAnalysis writes; strtoull
+    // alone would also take a sign, spaces or capitals.
+    std::string hex = line.substr(0, bar);
+    if (hex.find_first_not_of("0123456789abcdef") != std::string::npos)
+        return false;
+    key = std::strtoull(hex.c_str(), nullptr, 16);
+
+    size_t pos = bar + 1;
+    while (pos < line.size()) {
+        MoveEvaluation evaluation;
+        if (pos + 2 > line.size() || !charValue(line[pos], evaluation.before) ||
+            !charValue(line[pos + 1], evaluation.after))
+            return false;
+        evaluations.push_back(evaluation);
+        pos += 2;
+        if (pos < line.size()) {
+            // The encoder only writes ';' between entries, never after the last.
+            if (line[pos] != ';' || pos + 1 == line.size())
+                return false;
+            ++pos;
+        }
+    }
+    return true;
+}
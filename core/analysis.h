@@ -0,0 +1,41 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+// Post-game analysis: the game-theoretic value of every move in a record,
+// plus a text format for caching the results next to the history file.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gamecore.h"
+
+// --- MoveEvaluation Struct Definition ---
+// Values are from the mover's point of view: 1 = win, 0 = draw, -1 = loss.
+// before is the best the mover could get, after is what the played move keeps.
+struct MoveEvaluation {
+    int before;
+    int after;
+};
+
+enum MoveVerdict {
+    VERDICT_GOOD,
+    VERDICT_MISSED_WIN, // had a forced win and let it go
+    VERDICT_BLUNDER     // turned a draw into a loss
+};
+
+// Evaluates every move with the minimax search. Stops at the first illegal
+// move or after the game is decided; returns false if a move was illegal.
+bool analyseGame(const GameRecord &record, std::vector<MoveEvaluation> &evaluations);
+MoveVerdict moveVerdict(const MoveEvaluation &evaluation);
+const char *valueName(int value);
+
+// Content hash of a record, so identical games share one cache entry.
+uint64_t gameRecordKey(const GameRecord &record);
+
+// Cache line format: <hex key>|<before><after>;<before><after>;... with
+// each value written as L, D or W.
+std::string encodeAnalysis(uint64_t key, const std::vector<MoveEvaluation> &evaluations);
+bool decodeAnalysis(const std::string &line, uint64_t &key, std::vector<MoveEvaluation> &evaluations);
+
+#endif // ANALYSIS_H
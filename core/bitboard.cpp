@@ -0,0 +1,39 @@
+#include "bitboard.h"
+
+Variant makeVariant(int size, int k) {
+    Variant variant;
+    variant.size = size;
+    variant.k = k;
+    variant.cells = 0;
+    variant.full = 0;
+    if (size < 1 || size > 8 || k < 1 || k > size)
+        return variant;
+
+    variant.cells = size * size;
+    variant.full = (variant.cells == 64) ? ~CellMask(0) : cellBit(variant.cells) - 1;
+
+    // Directions: right, down, down-right, down-left.
+    const int dirs[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+    for (int row = 0; row < size; ++row) {
+        for (int col = 0; col < size; ++col) {
+            for (const auto &dir : dirs) {
+                int endRow = row + dir[0] * (k - 1);
+                int endCol = col + dir[1] * (k - 1);
+                if (endRow < 0 || endRow >= size || endCol < 0 || endCol >= size)
+                    continue;
+                CellMask line = 0;
+                for (int i = 0; i < k; ++i)
+                    line |= cellBit((row + dir[0] * i) * size + col + dir[1] * i);
+                variant.lines.push_back(line);
+            }
+        }
+    }
+    return variant;
+}
+
+bool hasLine(const Variant &variant, CellMask stones) {
+    for (CellMask line : variant.lines)
+        if ((stones & line) == line)
+            return true;
+    return false;
+}
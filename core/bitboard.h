@@ -0,0 +1,47 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+// Bitboard representation of size x size boards where k stones in a row win.
+// Cell (row, col) is bit row * size + col; boards up to 8x8 fit in a mask.
+
+#include <cstdint>
+#include <vector>
+
+typedef uint64_t CellMask;
+
+// --- Variant Struct Definition ---
+// Board geometry plus every winning line as a mask of k cells.
+struct Variant {
+    int size;
+    int k;
+    int cells;
+    CellMask full;
+    std::vector<CellMask> lines;
+};
+
+// --- Position Struct Definition ---
+// Stones of each side. X always moves first, so the side to move follows
+// from the stone counts.
+struct Position {
+    CellMask x;
+    CellMask o;
+};
+
+// Returns a variant with no lines when size/k are out of range (1..8).
+Variant makeVariant(int size, int k);
+
+#ifdef _MSC_VER
+#include <intrin.h>
+inline int popCount(CellMask mask) { return static_cast<int>(__popcnt64(mask)); }
+inline int lowestCell(CellMask mask) { unsigned long index; _BitScanForward64(&index, mask); return static_cast<int>(index); }
+#else
+inline int popCount(CellMask mask) { return __builtin_popcountll(mask); }
+inline int lowestCell(CellMask mask) { return __builtin_ctzll(mask); }
+#endif
+inline CellMask cellBit(int cell) { return CellMask(1) << cell; }
+
+bool hasLine(const Variant &variant, CellMask stones);
+inline char sideToMove(const Position &pos) { return popCount(pos.x) > popCount(pos.o) ? 'O' : 'X'; }
+inline CellMask emptyCells(const Variant &variant, const Position &pos) { return variant.full & ~(pos.x | pos.o); }
+
+#endif // BITBOARD_H
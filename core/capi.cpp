@@ -0,0 +1,214 @@
+#include "tictactoe.h"
+#include "bitboard.h"
+#include "gamecore.h"
+#include "search.h"
+#include "tablebase.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------
+// Game object
+
+struct ttt_game {
+    Variant variant;
+    Position pos;
+    std::vector<int> moves; // cells in play order, for undo and saving
+    std::shared_ptr<const Tablebase> tablebase; // consulted by ttt_game_best_move
+};
+
+namespace {
+
+int resultOf(const ttt_game &game) {
+    if (hasLine(game.variant, game.pos.x))
+        return TTT_X_WINS;
+    if (hasLine(game.variant, game.pos.o))
+        return TTT_O_WINS;
+    return emptyCells(game.variant, game.pos) == 0 ? TTT_DRAW : TTT_ONGOING;
+}
+
+bool onBoard(const ttt_game &game, int row, int col) {
+    return row >= 0 && row < game.variant.size && col >= 0 && col < game.variant.size;
+}
+
+} // namespace
+
+// ------------------------------------------------------------------
+// C API Implementation
+//
+// Every entry point that can allocate catches everything: exceptions must
+// not cross into C callers.
+
+int ttt_api_version(void) {
+    return TTT_API_VERSION;
+}
+
+ttt_game *ttt_game_new(int size, int k) {
+    try {
+        Variant variant = makeVariant(size, k);
+        if (variant.cells == 0)
+            return nullptr;
+        ttt_game *game = new ttt_game;
+        game->variant = std::move(variant);
+        game->pos = Position{ 0, 0 };
+        game->moves.reserve(game->variant.cells);
+        return game;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void ttt_game_free(ttt_game *game) {
+    delete game;
+}
+
+void ttt_game_reset(ttt_game *game) {
+    if (!game)
+        return;
+    game->pos = Position{ 0, 0 };
+    game->moves.clear();
+}
+
+int ttt_game_size(const ttt_game *game) {
+    return game ? game->variant.size : TTT_ERROR_ARGUMENT;
+}
+
+int ttt_game_move_count(const ttt_game *game) {
+    return game ? static_cast<int>(game->moves.size()) : TTT_ERROR_ARGUMENT;
+}
+
+char ttt_game_cell(const ttt_game *game, int row, int col) {
+    if (!game || !onBoard(*game, row, col))
+        return ' ';
+    const CellMask bit = cellBit(row * game->variant.size + col);
+    return (game->pos.x & bit) ? 'X' : ((game->pos.o & bit) ? 'O' : ' ');
+}
+
+char ttt_game_to_move(const ttt_game *game) {
+    return game ? sideToMove(game->pos) : 'X';
+}
+
+int ttt_game_result(const ttt_game *game) {
+    return game ? resultOf(*game) : TTT_ERROR_ARGUMENT;
+}
+
+int ttt_game_play(ttt_game *game, int row, int col) {
+    if (!game || !onBoard(*game, row, col))
+        return TTT_ERROR_ARGUMENT;
+    const int cell = row * game->variant.size + col;
+    if (resultOf(*game) != TTT_ONGOING || !(emptyCells(game->variant, game->pos) & cellBit(cell)))
+        return TTT_ERROR_ILLEGAL;
+    (sideToMove(game->pos) == 'X' ? game->pos.x : game->pos.o) |= cellBit(cell);
+    game->moves.push_back(cell); // capacity reserved in ttt_game_new, so this cannot throw
+    return TTT_OK;
+}
+
+int ttt_game_undo(ttt_game *game) {
+    if (!game)
+        return TTT_ERROR_ARGUMENT;
+    if (game->moves.empty())
+        return TTT_ERROR_ILLEGAL;
+    const CellMask bit = cellBit(game->moves.back());
+    game->pos.x &= ~bit;
+    game->pos.o &= ~bit;
+    game->moves.pop_back();
+    return TTT_OK;
+}
+
+int ttt_game_use_tablebase(ttt_game *game, const char *path) {
+    if (!game)
+        return TTT_ERROR_ARGUMENT;
+    try {
+        if (!path) {
+            game->tablebase.reset();
+            return TTT_OK;
+        }
+        std::shared_ptr<Tablebase> table = std::make_shared<Tablebase>();
+        if (!table->open(path) || table->variant().size != game->variant.size ||
+            table->variant().k != game->variant.k)
+            return TTT_ERROR_FORMAT;
+        game->tablebase = std::move(table);
+        return TTT_OK;
+    } catch (...) {
+        return TTT_ERROR_MEMORY;
+    }
+}
+
+int ttt_game_best_move(const ttt_game *game, int depth, int time_ms, int *row, int *col, int *score) {
+    if (!game || !row || !col || depth < 0 || time_ms < 0)
+        return TTT_ERROR_ARGUMENT;
+    try {
+        EngineConfig config;
+        config.depth = depth > 0 ? depth : game->variant.cells;
+        config.timeMs = time_ms;
+        config.alphaBeta = true;
+        config.network = nullptr;
+        config.proofNodes = 0;
+        config.proofTableBytes = 0;
+        config.tablebase = game->tablebase.get();
+        const SearchResult result = searchMove(game->variant, game->pos, config);
+        if (result.cell < 0)
+            return TTT_ERROR_ILLEGAL;
+        *row = result.cell / game->variant.size;
+        *col = result.cell % game->variant.size;
+        if (score)
+            *score = result.score;
+        return TTT_OK;
+    } catch (...) {
+        return TTT_ERROR_MEMORY;
+    }
+}
+
+int ttt_game_load_record(ttt_game *game, const char *line) {
+    if (!game || !line)
+        return TTT_ERROR_ARGUMENT;
+    try {
+        GameRecord record;
+        if (!decodeGameRecord(line, record) || isUltimateRecord(record))
+            return TTT_ERROR_FORMAT;
+        ttt_game replay = *game;
+        ttt_game_reset(&replay);
+        for (const Move &m : record.moves) {
+            if (m.player != ttt_game_to_move(&replay) || ttt_game_play(&replay, m.row, m.col) != TTT_OK)
+                return TTT_ERROR_ILLEGAL;
+        }
+        game->pos = replay.pos;
+        game->moves.assign(replay.moves.begin(), replay.moves.end());
+        return TTT_OK;
+    } catch (...) {
+        return TTT_ERROR_MEMORY;
+    }
+}
+
+int ttt_game_save_record(const ttt_game *game, const char *mode, const char *winner, char *buffer, size_t size) {
+    if (!game || !mode || (!buffer && size > 0))
+        return TTT_ERROR_ARGUMENT;
+    try {
+        GameRecord record;
+        record.mode = mode;
+        if (winner) {
+            record.winner = winner;
+        } else {
+            const int result = resultOf(*game);
+            record.winner = result == TTT_X_WINS ? "X" : (result == TTT_O_WINS ? "O" : (result == TTT_DRAW ? "Draw" : ""));
+        }
+        Position pos = { 0, 0 };
+        for (int cell : game->moves) {
+            const char player = sideToMove(pos);
+            (player == 'X' ? pos.x : pos.o) |= cellBit(cell);
+            record.moves.push_back(Move{ cell / game->variant.size, cell % game->variant.size, player });
+        }
+        const std::string line = encodeGameRecord(record);
+        if (size > 0) {
+            const size_t count = std::min(line.size(), size - 1);
+            std::memcpy(buffer, line.data(), count);
+            buffer[count] = '\0';
+        }
+        return static_cast<int>(line.size());
+    } catch (...) {
+        return TTT_ERROR_MEMORY;
+    }
+}
@@ -0,0 +1,48 @@
+# Qt-free game rules, AI and history format shared by the app and the tools.
+# Including this file compiles the core into the including target; core.pro
+# builds the same sources as a standalone library with the C API in
+# tictactoe.h.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# CONFIG += alloc_tracking counts heap allocations per thread (allocstats.h).
+alloc_tracking: DEFINES += ALLOC_TRACKING
+
+SOURCES += \
+    $$PWD/gamecore.cpp \
+    $$PWD/bitboard.cpp \
+    $$PWD/tablebase.cpp \
+    $$PWD/winbatch.cpp \
+    $$PWD/analysis.cpp \
+    $$PWD/positionindex.cpp \
+    $$PWD/movetrie.cpp \
+    $$PWD/journal.cpp \
+    $$PWD/perft.cpp \
+    $$PWD/allocstats.cpp \
+    $$PWD/search.cpp \
+    $$PWD/proofsearch.cpp \
+    $$PWD/threatmap.cpp \
+    $$PWD/neuralnet.cpp \
+    $$PWD/historycache.cpp \
+    $$PWD/ultimate.cpp \
+    $$PWD/capi.cpp
+
+HEADERS += \
+    $$PWD/gamecore.h \
+    $$PWD/bitboard.h \
+    $$PWD/tablebase.h \
+    $$PWD/winbatch.h \
+    $$PWD/analysis.h \
+    $$PWD/positionindex.h \
+    $$PWD/movetrie.h \
+    $$PWD/journal.h \
+    $$PWD/perft.h \
+    $$PWD/allocstats.h \
+    $$PWD/search.h \
+    $$PWD/proofsearch.h \
+    $$PWD/threatmap.h \
+    $$PWD/neuralnet.h \
+    $$PWD/historycache.h \
+    $$PWD/ultimate.h \
+    $$PWD/tictactoe.h
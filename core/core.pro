@@ -0,0 +1,18 @@
+# Standalone game core library: rules, engines and history codec, with no
+# Qt dependency. Static by default; qmake CONFIG+=core_shared builds a
+# shared library that exports only the C API (tictactoe.h).
+
+TEMPLATE = lib
+CONFIG -= qt
+CONFIG += c++17
+
+TARGET = tictactoecore
+
+core_shared {
+    CONFIG += shared hide_symbols
+    DEFINES += TTT_BUILD_SHARED
+} else {
+    CONFIG += staticlib
+}
+
+include(core.pri)
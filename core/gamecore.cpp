@@ -0,0 +1,244 @@
+#include "gamecore.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// ------------------------------------------------------------------
+// Helper functions
+
+// Splits on a single separator, keeping empty fields (like QString::split).
+static std::vector<std::string> splitString(const std::string &text, char separator) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        size_t end = text.find(separator, start);
+        if (end == std::string::npos) {
+            parts.push_back(text.substr(start));
+            break;
+        }
+        parts.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+// Parses a whole field as an integer, returning 0 on failure (like QString::toInt).
+static int parseInt(const std::string &text) {
+    if (text.empty())
+        return 0;
+    char *end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0')
+        return 0;
+    return static_cast<int>(value);
+}
+
+// ------------------------------------------------------------------
+// Rules
+
+BoardState emptyBoard() {
+    return BoardState(3, std::vector<char>(3, ' '));
+}
+
+bool evalIsWinner(const BoardState &board, char player) {
+    for (int i = 0; i < 3; i++) {
+        if (board[i][0] == player && board[i][1] == player && board[i][2] == player)
+            return true;
+        if (board[0][i] == player && board[1][i] == player && board[2][i] == player)
+            return true;
+    }
+    if (board[0][0] == player && board[1][1] == player && board[2][2] == player)
+        return true;
+    if (board[0][2] == player && board[1][1] == player && board[2][0] == player)
+        return true;
+    return false;
+}
+
+bool evalIsFull(const BoardState &board) {
+    for (const auto &row : board)
+        for (char cell : row)
+            if (cell == ' ')
+                return false;
+    return true;
+}
+
+// ------------------------------------------------------------------
+// AI
+
+static const int kLines[8][3] = {
+    { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 },
+    { 0, 3, 6 }, { 1, 4, 7 }, { 2, 5, 8 },
+    { 0, 4, 8 }, { 2, 4, 6 },
+};
+
+static bool searchIsWinner(const SearchBoard &board, char player) {
+    for (const auto &line : kLines)
+        if (board.cells[line[0]] == player && board.cells[line[1]] == player && board.cells[line[2]] == player)
+            return true;
+    return false;
+}
+
+SearchBoard toSearchBoard(const BoardState &board) {
+    SearchBoard flat;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            flat.cells[i * 3 + j] = board[i][j];
+    return flat;
+}
+
+void generateMoves(const SearchBoard &board, MoveList &moves) {
+    moves.count = 0;
+    for (int cell = 0; cell < 9; cell++)
+        if (board.cells[cell] == ' ')
+            moves.cells[moves.count++] = cell;
+}
+
+int searchMinimax(SearchBoard &board, char player) {
+    if (searchIsWinner(board, 'O'))
+        return 10;
+    if (searchIsWinner(board, 'X'))
+        return -10;
+    MoveList moves;
+    generateMoves(board, moves);
+    if (moves.count == 0)
+        return 0;
+
+    // 'O' maximises, 'X' minimises.
+    const bool maximizing = (player == 'O');
+    const char opponent = maximizing ? 'X' : 'O';
+    int bestScore = maximizing ? -1000 : 1000;
+    for (int i = 0; i < moves.count; i++) {
+        char &cell = board.cells[moves.cells[i]];
+        cell = player;
+        int score = searchMinimax(board, opponent);
+        cell = ' ';
+        bestScore = maximizing ? std::max(bestScore, score) : std::min(bestScore, score);
+    }
+    return bestScore;
+}
+
+// ------------------------------------------------------------------
+// MinimaxCache Implementation
+
+static const int kPow3[9] = { 1, 3, 9, 27, 81, 243, 729, 2187, 6561 };
+static const signed char kUnknown = 127;
+
+static int cellDigit(char cell) {
+    return cell == 'X' ? 1 : (cell == 'O' ? 2 : 0);
+}
+
+MinimaxCache::MinimaxCache()
+    : table(2 * 19683, kUnknown)
+{
+}
+
+int MinimaxCache::score(SearchBoard &board, char player)
+{
+    int key = 0;
+    for (int cell = 0; cell < 9; cell++)
+        key += cellDigit(board.cells[cell]) * kPow3[cell];
+    return search(board, player, key);
+}
+
+// Same recursion as searchMinimax, with the base-3 board key kept up to date.
+int MinimaxCache::search(SearchBoard &board, char player, int key)
+{
+    signed char &entry = table[(player == 'O' ? 19683 : 0) + key];
+    if (entry != kUnknown)
+        return entry;
+
+    int bestScore;
+    MoveList moves;
+    generateMoves(board, moves);
+    if (searchIsWinner(board, 'O'))
+        bestScore = 10;
+    else if (searchIsWinner(board, 'X'))
+        bestScore = -10;
+    else if (moves.count == 0)
+        bestScore = 0;
+    else {
+        const bool maximizing = (player == 'O');
+        const char opponent = maximizing ? 'X' : 'O';
+        bestScore = maximizing ? -1000 : 1000;
+        for (int i = 0; i < moves.count; i++) {
+            const int cell = moves.cells[i];
+            board.cells[cell] = player;
+            int score = search(board, opponent, key + cellDigit(player) * kPow3[cell]);
+            board.cells[cell] = ' ';
+            bestScore = maximizing ? std::max(bestScore, score) : std::min(bestScore, score);
+        }
+    }
+    entry = static_cast<signed char>(bestScore);
+    return bestScore;
+}
+
+int evalMinimax(BoardState &board, char player) {
+    SearchBoard flat = toSearchBoard(board);
+    return searchMinimax(flat, player);
+}
+
+bool evalBestMove(const BoardState &board, int &bestRow, int &bestCol, int *bestScore) {
+    int best = -1000;
+    bestRow = -1;
+    bestCol = -1;
+    SearchBoard flat = toSearchBoard(board);
+    MoveList moves;
+    generateMoves(flat, moves);
+
+    for (int i = 0; i < moves.count; i++) {
+        const int cell = moves.cells[i];
+        flat.cells[cell] = 'O'; // AI move candidate
+        int score = searchMinimax(flat, 'X');
+        flat.cells[cell] = ' ';
+        if (score > best) {
+            best = score;
+            bestRow = cell / 3;
+            bestCol = cell % 3;
+        }
+    }
+    if (bestScore)
+        *bestScore = best;
+    return bestRow != -1;
+}
+
+// ------------------------------------------------------------------
+// History format
+
+const char *const kUltimateMode = "Ultimate";
+
+std::string encodeGameRecord(const GameRecord &record) {
+    std::string line = record.mode + "|" + record.winner + "|";
+    for (size_t i = 0; i < record.moves.size(); ++i) {
+        const Move &m = record.moves[i];
+        line += std::to_string(m.row) + "-" + std::to_string(m.col) + "-" + m.player;
+        if (i < record.moves.size() - 1)
+            line += ";";
+    }
+    return line;
+}
+
+bool decodeGameRecord(const std::string &line, GameRecord &record) {
+    std::vector<std::string> fields = splitString(line, '|');
+    if (fields.size() < 2)
+        return false;
+    record.mode = fields[0];
+    record.winner = fields[1];
+    record.moves.clear();
+    if (fields.size() == 3 && !fields[2].empty()) {
+        for (const std::string &token : splitString(fields[2], ';')) {
+            std::vector<std::string> parts = splitString(token, '-');
+            if (parts.size() == 3 && !parts[2].empty()) {
+                Move m;
+                m.row = parseInt(parts[0]);
+                m.col = parseInt(parts[1]);
+                m.player = parts[2][0];
+                record.moves.push_back(m);
+            }
+        }
+    }
+    return true;
+}
+
+bool isUltimateRecord(const GameRecord &record) {
+    return record.mode == kUltimateMode;
+}
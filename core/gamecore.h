@@ -0,0 +1,88 @@
+#ifndef GAMECORE_H
+#define GAMECORE_H
+
+// Game rules, minimax AI and the history line format, kept free of any Qt
+// dependency so they can be shared by the GUI and the headless tools.
+
+#include <string>
+#include <vector>
+
+// --- Move Struct Definition ---
+// Records each move's row, column, and the player that moved.
+struct Move {
+    int row;
+    int col;
+    char player;
+};
+
+// --- GameRecord Struct Definition ---
+// Stores the game mode, winner and the full move history.
+struct GameRecord {
+    std::string mode;
+    std::string winner;
+    std::vector<Move> moves;
+};
+
+// A 3x3 board of 'X', 'O' and ' ' cells, indexed as board[row][col].
+typedef std::vector<std::vector<char>> BoardState;
+
+// ------------------------------------------------------------------
+// Rules
+
+BoardState emptyBoard();
+bool evalIsWinner(const BoardState &board, char player);
+bool evalIsFull(const BoardState &board);
+
+// ------------------------------------------------------------------
+// AI (the AI always plays 'O' and maximises, 'X' minimises)
+
+// --- SearchBoard Struct Definition ---
+// Flat board the search plays on, cell row * 3 + col. Moves are made and
+// unmade in place and the board lives on the stack, so a search performs
+// no heap allocation.
+struct SearchBoard {
+    char cells[9];
+};
+
+// --- MoveList Struct Definition ---
+// Empty cells of a SearchBoard in row-major order, with fixed capacity.
+struct MoveList {
+    int count;
+    int cells[9];
+};
+
+SearchBoard toSearchBoard(const BoardState &board);
+void generateMoves(const SearchBoard &board, MoveList &moves);
+int searchMinimax(SearchBoard &board, char player);
+
+int evalMinimax(BoardState &board, char player);
+
+// --- MinimaxCache Class Definition ---
+// Memoised searchMinimax over every 3x3 board (3^9 boards per side to move),
+// so values found for one move are reused by all later moves and games.
+class MinimaxCache
+{
+public:
+    MinimaxCache();
+    int score(SearchBoard &board, char player);
+
+private:
+    int search(SearchBoard &board, char player, int key);
+    std::vector<signed char> table;
+};
+// Returns false when the board has no empty cell left.
+bool evalBestMove(const BoardState &board, int &bestRow, int &bestCol, int *bestScore = nullptr);
+
+// ------------------------------------------------------------------
+// History format: mode|winner|row-col-player;row-col-player;...
+// Ultimate games (mode kUltimateMode) use 9x9 coordinates: row and col
+// 0..8, sub-board (row / 3, col / 3), cell (row % 3, col % 3) inside it.
+
+extern const char *const kUltimateMode;
+
+std::string encodeGameRecord(const GameRecord &record);
+// Returns false for lines that do not contain at least mode and winner.
+bool decodeGameRecord(const std::string &line, GameRecord &record);
+bool isUltimateRecord(const GameRecord &record);
+
+#endif // GAMECORE_H
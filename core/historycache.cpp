@@ -0,0 +1,125 @@
+#include "historycache.h"
+
+// ------------------------------------------------------------------
+// Entry size
+
+size_t cachedHistoryBytes(const CachedHistory &entry) {
+    size_t bytes = sizeof(CachedHistory) + entry.games.capacity() * sizeof(GameRecord);
+    for (const GameRecord &record : entry.games)
+        bytes += record.mode.capacity() + record.winner.capacity() + record.moves.capacity() * sizeof(Move);
+    bytes += entry.trie.memoryUsage() + entry.positions.memoryUsage();
+    bytes += entry.analysis.bucket_count() * sizeof(void*);
+    for (const auto &analysis : entry.analysis)
+        bytes += sizeof(analysis) + sizeof(void*) + analysis.second.capacity() * sizeof(MoveEvaluation);
+    return bytes;
+}
+
+// ------------------------------------------------------------------
+// HistoryCache Implementation
+
+HistoryCache::HistoryCache(size_t budget)
+    : capacityBytes(budget), usedBytes(0), hitCount(0), missCount(0)
+{
+}
+
+void HistoryCache::setCapacity(size_t budget)
+{
+    capacityBytes = budget;
+    evict();
+}
+
+size_t HistoryCache::capacity() const
+{
+    return capacityBytes;
+}
+
+size_t HistoryCache::bytes() const
+{
+    return usedBytes;
+}
+
+size_t HistoryCache::count() const
+{
+    return slots.size();
+}
+
+uint64_t HistoryCache::hits() const
+{
+    return hitCount;
+}
+
+uint64_t HistoryCache::misses() const
+{
+    return missCount;
+}
+
+bool HistoryCache::put(const std::string &user, CachedHistory &&entry)
+{
+    erase(user);
+    const size_t bytes = cachedHistoryBytes(entry);
+    if (bytes > capacityBytes)
+        return false;
+    slots.push_front(Slot{ user, std::move(entry), bytes });
+    lookup[user] = slots.begin();
+    usedBytes += bytes;
+    evict();
+    return true;
+}
+
+bool HistoryCache::take(const std::string &user, CachedHistory &entry)
+{
+    auto it = lookup.find(user);
+    if (it == lookup.end()) {
+        missCount++;
+        return false;
+    }
+    hitCount++;
+    entry = std::move(it->second->entry);
+    usedBytes -= it->second->bytes;
+    slots.erase(it->second);
+    lookup.erase(it);
+    return true;
+}
+
+CachedHistory *HistoryCache::find(const std::string &user)
+{
+    auto it = lookup.find(user);
+    return it == lookup.end() ? nullptr : &it->second->entry;
+}
+
+void HistoryCache::remeasure(const std::string &user)
+{
+    auto it = lookup.find(user);
+    if (it == lookup.end())
+        return;
+    usedBytes -= it->second->bytes;
+    it->second->bytes = cachedHistoryBytes(it->second->entry);
+    usedBytes += it->second->bytes;
+    evict();
+}
+
+void HistoryCache::erase(const std::string &user)
+{
+    auto it = lookup.find(user);
+    if (it == lookup.end())
+        return;
+    usedBytes -= it->second->bytes;
+    slots.erase(it->second);
+    lookup.erase(it);
+}
+
+void HistoryCache::clear()
+{
+    slots.clear();
+    lookup.clear();
+    usedBytes = 0;
+}
+
+void HistoryCache::evict()
+{
+    while (usedBytes > capacityBytes && !slots.empty()) {
+        usedBytes -= slots.back().bytes;
+        lookup.erase(slots.back().user);
+        slots.pop_back();
+    }
+}
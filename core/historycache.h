@@ -0,0 +1,76 @@
+#ifndef HISTORYCACHE_H
+#define HISTORYCACHE_H
+
+// In-memory copies of the per-user state loaded at sign-in (games, history
+// trie, position index, analysis), so switching back to a recent account
+// does not re-read and re-parse its files. Least recently used entries are
+// evicted to keep the total under a byte budget.
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gamecore.h"
+#include "analysis.h"
+#include "movetrie.h"
+#include "positionindex.h"
+
+// --- CachedHistory Struct Definition ---
+struct CachedHistory {
+    std::vector<GameRecord> games;
+    MoveTrie trie;
+    PositionIndex positions;
+    std::unordered_map<uint64_t, std::vector<MoveEvaluation>> analysis;
+    int64_t stamp; // caller's version of the history file the entry matches
+};
+
+// Approximate heap bytes held by an entry.
+size_t cachedHistoryBytes(const CachedHistory &entry);
+
+// --- HistoryCache Class Definition ---
+class HistoryCache
+{
+public:
+    explicit HistoryCache(size_t budget = 16 * 1024 * 1024);
+
+    // Lowering the capacity evicts at once.
+    void setCapacity(size_t budget);
+    size_t capacity() const;
+    size_t bytes() const;
+    size_t count() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+    // Stores entry as the most recently used one, replacing any entry for
+    // user, then evicts from the cold end until the total fits. An entry
+    // larger than the whole budget is not kept; returns false then.
+    bool put(const std::string &user, CachedHistory &&entry);
+    // Moves user's entry out of the cache (a hit) or returns false (a miss).
+    bool take(const std::string &user, CachedHistory &entry);
+    // Access for write-through updates; does not change the LRU order.
+    // Call remeasure() after changing the entry.
+    CachedHistory *find(const std::string &user);
+    void remeasure(const std::string &user);
+    void erase(const std::string &user);
+    void clear();
+
+private:
+    struct Slot {
+        std::string user;
+        CachedHistory entry;
+        size_t bytes;
+    };
+
+    void evict();
+
+    std::list<Slot> slots; // most recently used first
+    std::unordered_map<std::string, std::list<Slot>::iterator> lookup;
+    size_t capacityBytes;
+    size_t usedBytes;
+    uint64_t hitCount;
+    uint64_t missCount;
+};
+
+#endif // HISTORYCACHE_H
@@ -0,0 +1,246 @@
+#include "journal.h"
+
+#include <fcntl.h>
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// ------------------------------------------------------------------
+// Helper functions
+
+namespace {
+
+#ifdef _WIN32
+int openFile(const char *path) { return _open(path, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE); }
+int openForAppend(const char *path) { return _open(path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE); }
+int openForWrite(const char *path) { return _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE); }
+long long readFile(int fd, void *buffer, size_t size) { return _read(fd, buffer, static_cast<unsigned>(size)); }
+long long writeFile(int fd, const void *buffer, size_t size) { return _write(fd, buffer, static_cast<unsigned>(size)); }
+long long seekFile(int fd, long long offset, int whence) { return _lseeki64(fd, offset, whence); }
+bool truncateFile(int fd, long long size) { return _chsize_s(fd, size) == 0; }
+bool syncFile(int fd) { return _commit(fd) == 0; }
+bool closeFile(int fd) { return _close(fd) == 0; }
+bool renameFile(const char *from, const char *to) {
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+#else
+int openFile(const char *path) { return ::open(path, O_RDWR | O_CREAT, 0644); }
+int openForAppend(const char *path) { return ::open(path, O_WRONLY | O_CREAT | O_APPEND, 0644); }
+int openForWrite(const char *path) { return ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644); }
+long long readFile(int fd, void *buffer, size_t size) { return ::read(fd, buffer, size); }
+long long writeFile(int fd, const void *buffer, size_t size) { return ::write(fd, buffer, size); }
+long long seekFile(int fd, long long offset, int whence) { return ::lseek(fd, offset, whence); }
+bool truncateFile(int fd, long long size) { return ::ftruncate(fd, size) == 0; }
+#ifdef __APPLE__
+bool syncFile(int fd) { return ::fsync(fd) == 0; }
+#else
+bool syncFile(int fd) { return ::fdatasync(fd) == 0; }
+#endif
+bool closeFile(int fd) { return ::close(fd) == 0; }
+// The rename itself is only durable once the directory entry is flushed.
+bool renameFile(const char *from, const char *to) {
+    if (::rename(from, to) != 0)
+        return false;
+    std::string dir(to);
+    const size_t slash = dir.rfind('/');
+    dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : dir.substr(0, slash));
+    const int fd = ::open(dir.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    const bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+#endif
+
+// Largest record accepted on recovery; anything bigger is treated as garbage.
+const uint32_t kMaxRecord = 1 << 20;
+
+bool readExact(int fd, void *buffer, size_t size) {
+    char *out = static_cast<char*>(buffer);
+    while (size > 0) {
+        long long n = readFile(fd, out, size);
+        if (n <= 0)
+            return false;
+        out += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeExact(int fd, const void *buffer, size_t size) {
+    const char *in = static_cast<const char*>(buffer);
+    while (size > 0) {
+        long long n = writeFile(fd, in, size);
+        if (n <= 0)
+            return false;
+        in += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+uint32_t decodeU32(const unsigned char *bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+void encodeU32(unsigned char *bytes, uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+        bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+}
+
+} // namespace
+
+bool appendToFile(const std::string &path, const std::string &bytes) {
+    const int fd = openForAppend(path.c_str());
+    if (fd < 0)
+        return false;
+    const bool written = writeExact(fd, bytes.data(), bytes.size());
+    return closeFile(fd) && written;
+}
+
+bool syncFileToDisk(const std::string &path) {
+    const int fd = openFile(path.c_str());
+    if (fd < 0)
+        return false;
+    const bool synced = syncFile(fd);
+    return closeFile(fd) && synced;
+}
+
+bool replaceFileAtomically(const std::string &path, const std::string &bytes) {
+    const std::string temp = path + ".tmp";
+    const int fd = openForWrite(temp.c_str());
+    if (fd < 0)
+        return false;
+    const bool written = writeExact(fd, bytes.data(), bytes.size()) && syncFile(fd);
+    if (!closeFile(fd) || !written || !renameFile(temp.c_str(), path.c_str())) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint32_t crc32(const void *data, size_t size) {
+    static const struct Table {
+        uint32_t value[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                value[i] = c;
+            }
+        }
+    } table;
+    uint32_t crc = 0xFFFFFFFFu;
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+        crc = table.value[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// ------------------------------------------------------------------
+// Journal Implementation
+
+Journal::Journal()
+    : fd(-1), records(0)
+{
+}
+
+Journal::~Journal()
+{
+    close();
+}
+
+bool Journal::open(const std::string &path, std::vector<std::string> &recovered)
+{
+    close();
+    recovered.clear();
+    fd = openFile(path.c_str());
+    if (fd < 0)
+        return false;
+
+    long long goodEnd = 0;
+    while (true) {
+        unsigned char header[8];
+        if (!readExact(fd, header, sizeof(header)))
+            break;
+        const uint32_t length = decodeU32(header);
+        const uint32_t checksum = decodeU32(header + 4);
+        if (length > kMaxRecord)
+            break;
+        std::string payload(length, '\0');
+        if (length > 0 && !readExact(fd, &payload[0], length))
+            break;
+        if (crc32(payload.data(), payload.size()) != checksum)
+            break;
+        recovered.push_back(payload);
+        goodEnd += sizeof(header) + length;
+    }
+
+    // Cut off whatever follows the last intact record, then append after it.
+    if (!truncateFile(fd, goodEnd) || seekFile(fd, goodEnd, SEEK_SET) != goodEnd) {
+        close();
+        return false;
+    }
+    records = recovered.size();
+    return true;
+}
+
+void Journal::close()
+{
+    if (fd >= 0)
+        closeFile(fd);
+    fd = -1;
+    records = 0;
+}
+
+bool Journal::isOpen() const
+{
+    return fd >= 0;
+}
+
+bool Journal::append(const std::string &payload)
+{
+    if (fd < 0 || payload.size() > kMaxRecord)
+        return false;
+    // One write per record keeps the append sequential and small.
+    std::string record(8, '\0');
+    encodeU32(reinterpret_cast<unsigned char*>(&record[0]), static_cast<uint32_t>(payload.size()));
+    encodeU32(reinterpret_cast<unsigned char*>(&record[4]), crc32(payload.data(), payload.size()));
+    record += payload;
+    const long long end = seekFile(fd, 0, SEEK_CUR);
+    if (end < 0)
+        return false;
+    if (!writeExact(fd, record.data(), record.size()) || !syncFile(fd)) {
+        // Cut off the partial record, or every later one would sit behind
+        // it and be dropped on recovery.
+        truncateFile(fd, end);
+        seekFile(fd, end, SEEK_SET);
+        return false;
+    }
+    ++records;
+    return true;
+}
+
+bool Journal::reset()
+{
+    if (fd < 0)
+        return false;
+    if (!truncateFile(fd, 0) || seekFile(fd, 0, SEEK_SET) != 0 || !syncFile(fd))
+        return false;
+    records = 0;
+    return true;
+}
+
+size_t Journal::recordCount() const
+{
+    return records;
+}
@@ -0,0 +1,52 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+// Write-ahead journal: an append-only file of checksummed records, each
+// flushed to disk before append() returns. Owners apply the records to
+// their main files at checkpoints and then reset the journal.
+//
+// Record layout: length:u32 crc32:u32 payload (little-endian).
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+uint32_t crc32(const void *data, size_t size);
+
+// Helpers for the main files a checkpoint writes, so the journal is only
+// reset once they are on disk too.
+// Appends bytes to path (created if missing). Does not wait for the disk.
+bool appendToFile(const std::string &path, const std::string &bytes);
+// Waits until everything written to path has reached the disk.
+bool syncFileToDisk(const std::string &path);
+// Replaces path with bytes: a flushed temporary file renamed over it, so a
+// crash leaves either the old or the new contents.
+bool replaceFileAtomically(const std::string &path, const std::string &bytes);
+
+// --- Journal Class Definition ---
+class Journal
+{
+public:
+    Journal();
+    ~Journal();
+    Journal(const Journal &) = delete;
+    Journal &operator=(const Journal &) = delete;
+
+    // Opens (or creates) the journal and returns every intact record. A torn
+    // or corrupt tail, left by a crash mid-append, is cut off.
+    bool open(const std::string &path, std::vector<std::string> &records);
+    void close();
+    bool isOpen() const;
+
+    // Appends one record and waits for it to reach the disk.
+    bool append(const std::string &payload);
+    // Drops all records; call after they have been checkpointed.
+    bool reset();
+    size_t recordCount() const;
+
+private:
+    int fd;
+    size_t records;
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,278 @@
+#include "movetrie.h"
+#include "journal.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+// ------------------------------------------------------------------
+// Helper functions for the log format
+//
+// "TTMT" followed by records:
+//   'N' parent:u32 row:i32 col:i32 player:u8   new node (ids count up from 1)
+//   'S' length:u16 bytes                        new string (ids count up from 0)
+//   'G' leaf:u32 mode:u32 winner:u32            game
+// All integers are little-endian.
+
+namespace {
+
+const char kMagic[4] = { 'T', 'T', 'M', 'T' };
+
+void putU32(std::string &out, uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+bool getU32(const std::string &in, size_t &pos, uint32_t &value) {
+    if (pos + 4 > in.size())
+        return false;
+    value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(in[pos + i])) << (8 * i);
+    pos += 4;
+    return true;
+}
+
+// True only when nothing is at path. A file that exists but cannot be
+// opened (permissions, out of descriptors) is not missing.
+bool isMissing(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        std::fclose(file);
+        return false;
+    }
+    return errno == ENOENT;
+}
+
+} // namespace
+
+// ------------------------------------------------------------------
+// MoveTrie Implementation
+
+MoveTrie::MoveTrie()
+{
+    clear();
+}
+
+void MoveTrie::clear()
+{
+    nodes.assign(1, Node{ 0, 0, 0, 0, ' ' }); // root: the empty board
+    children.clear();
+    strings.clear();
+    stringIds.clear();
+    gameList.clear();
+    filePath.clear();
+}
+
+size_t MoveTrie::gameCount() const
+{
+    return gameList.size();
+}
+
+size_t MoveTrie::nodeCount() const
+{
+    return nodes.size();
+}
+
+size_t MoveTrie::memoryUsage() const
+{
+    // Hash nodes carry the key, the value and a next pointer; buckets one pointer.
+    size_t bytes = nodes.capacity() * sizeof(Node) + gameList.capacity() * sizeof(Game) + filePath.capacity();
+    bytes += children.size() * (sizeof(Edge) + sizeof(uint32_t) + sizeof(void*)) + children.bucket_count() * sizeof(void*);
+    bytes += stringIds.size() * (sizeof(std::string) + sizeof(uint32_t) + sizeof(void*)) + stringIds.bucket_count() * sizeof(void*);
+    for (const std::string &text : strings)
+        bytes += sizeof(std::string) + 2 * text.capacity(); // also the copy in stringIds
+    return bytes;
+}
+
+uint32_t MoveTrie::internString(const std::string &text, std::string &log)
+{
+    auto it = stringIds.find(text);
+    if (it != stringIds.end())
+        return it->second;
+    const std::string stored = text.substr(0, 0xFFFF);
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.push_back(stored);
+    stringIds[text] = id;
+    log += 'S';
+    log += static_cast<char>(stored.size() & 0xFF);
+    log += static_cast<char>((stored.size() >> 8) & 0xFF);
+    log += stored;
+    return id;
+}
+
+uint32_t MoveTrie::childNode(uint32_t parent, const Move &m, std::string &log)
+{
+    const Edge edge = { parent, m.row, m.col, m.player };
+    auto it = children.find(edge);
+    if (it != children.end())
+        return it->second;
+    uint32_t id = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node{ parent, nodes[parent].depth + 1, m.row, m.col, m.player });
+    children[edge] = id;
+    log += 'N';
+    putU32(log, parent);
+    putU32(log, static_cast<uint32_t>(m.row));
+    putU32(log, static_cast<uint32_t>(m.col));
+    log += m.player;
+    return id;
+}
+
+void MoveTrie::insertGame(const GameRecord &record, std::string &log)
+{
+    uint32_t node = 0;
+    for (const Move &m : record.moves)
+        node = childNode(node, m, log);
+    Game game;
+    game.leaf = node;
+    game.mode = internString(record.mode, log);
+    game.winner = internString(record.winner, log);
+    gameList.push_back(game);
+    log += 'G';
+    putU32(log, game.leaf);
+    putU32(log, game.mode);
+    putU32(log, game.winner);
+}
+
+bool MoveTrie::addGame(const GameRecord &record)
+{
+    const size_t oldNodes = nodes.size();
+    const size_t oldStrings = strings.size();
+    std::string log;
+    insertGame(record, log);
+    if (filePath.empty() || appendToFile(filePath, log))
+        return true;
+
+    // Undo the insert so the game is retried, not silently counted.
+    gameList.pop_back();
+    for (size_t id = oldNodes; id < nodes.size(); ++id) {
+        const Node &n = nodes[id];
+        children.erase(Edge{ n.parent, n.row, n.col, n.player });
+    }
+    nodes.resize(oldNodes);
+    for (const std::string *text : { &record.mode, &record.winner }) {
+        auto it = stringIds.find(*text);
+        if (it != stringIds.end() && it->second >= oldStrings)
+            stringIds.erase(it);
+    }
+    strings.resize(oldStrings);
+    return false;
+}
+
+GameRecord MoveTrie::game(size_t index) const
+{
+    GameRecord record;
+    const Game &game = gameList[index];
+    record.mode = strings[game.mode];
+    record.winner = strings[game.winner];
+    record.moves.resize(nodes[game.leaf].depth);
+    for (uint32_t node = game.leaf; node != 0; node = nodes[node].parent) {
+        const Node &n = nodes[node];
+        record.moves[n.depth - 1] = Move{ n.row, n.col, n.player };
+    }
+    return record;
+}
+
+std::vector<GameRecord> MoveTrie::games() const
+{
+    std::vector<GameRecord> records;
+    records.reserve(gameList.size());
+    for (size_t i = 0; i < gameList.size(); ++i)
+        records.push_back(game(i));
+    return records;
+}
+
+bool MoveTrie::load(const std::string &path, bool *missing)
+{
+    clear();
+    if (missing)
+        *missing = false;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        if (missing)
+            *missing = isMissing(path);
+        return false;
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(kMagic) || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0)
+        return false;
+
+    size_t pos = sizeof(kMagic);
+    bool torn = false;
+    while (pos < data.size() && !torn) {
+        const char tag = data[pos++];
+        uint32_t a = 0, b = 0, c = 0;
+        if (tag == 'N') {
+            torn = !getU32(data, pos, a) || !getU32(data, pos, b) || !getU32(data, pos, c) ||
+                   pos >= data.size() || a >= nodes.size();
+            if (!torn) {
+                Node node = { a, nodes[a].depth + 1, static_cast<int32_t>(b), static_cast<int32_t>(c), data[pos++] };
+                children.emplace(Edge{ node.parent, node.row, node.col, node.player },
+                                 static_cast<uint32_t>(nodes.size()));
+                nodes.push_back(node);
+            }
+        } else if (tag == 'S') {
+            torn = pos + 2 > data.size();
+            if (!torn) {
+                size_t length = static_cast<unsigned char>(data[pos]) | (static_cast<unsigned char>(data[pos + 1]) << 8);
+                pos += 2;
+                torn = pos + length > data.size();
+                if (!torn) {
+                    std::string text = data.substr(pos, length);
+                    pos += length;
+                    stringIds.emplace(text, static_cast<uint32_t>(strings.size()));
+                    strings.push_back(text);
+                }
+            }
+        } else if (tag == 'G') {
+            torn = !getU32(data, pos, a) || !getU32(data, pos, b) || !getU32(data, pos, c) ||
+                   a >= nodes.size() || b >= strings.size() || c >= strings.size();
+            if (!torn)
+                gameList.push_back(Game{ a, b, c });
+        } else {
+            torn = true;
+        }
+    }
+
+    if (torn) {
+        // Keep every complete game and drop the partial tail.
+        std::vector<GameRecord> complete = games();
+        return rebuild(path, complete);
+    }
+    filePath = path;
+    return true;
+}
+
+bool MoveTrie::rebuild(const std::string &path, const std::vector<GameRecord> &history)
+{
+    clear();
+    std::string log(kMagic, sizeof(kMagic));
+    for (const GameRecord &record : history)
+        insertGame(record, log);
+    if (!replaceFileAtomically(path, log))
+        return false;
+    filePath = path;
+    return true;
+}
+
+bool MoveTrie::migrate(const std::string &path, const std::vector<GameRecord> &history)
+{
+    // An existing file may hold games history lacks; it is never replaced.
+    if (!isMissing(path)) {
+        clear();
+        return false;
+    }
+    return rebuild(path, history);
+}
+
+bool MoveTrie::hasFile() const
+{
+    return !filePath.empty();
+}
+
+bool MoveTrie::sync() const
+{
+    return filePath.empty() || syncFileToDisk(filePath);
+}
@@ -0,0 +1,97 @@
+#ifndef MOVETRIE_H
+#define MOVETRIE_H
+
+// History storage that shares common move prefixes between games. Every
+// distinct move sequence prefix is one trie node; a game is a reference to
+// its last node plus its mode and winner (interned strings).
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gamecore.h"
+
+// --- MoveTrie Class Definition ---
+// The file is an append-only log of new nodes, new strings and games, so
+// both its size and its load time grow with the distinct prefixes rather
+// than with the total number of moves played.
+class MoveTrie
+{
+public:
+    MoveTrie();
+
+    void clear();
+    size_t gameCount() const;
+    size_t nodeCount() const; // including the empty root
+    // Approximate heap bytes held, for cache accounting.
+    size_t memoryUsage() const;
+    // Adds a game in memory and, if a file is attached, appends it there.
+    // A failed append leaves the trie as it was.
+    bool addGame(const GameRecord &record);
+    GameRecord game(size_t index) const;
+    std::vector<GameRecord> games() const;
+
+    // Loads the trie stored at path and keeps appending to it. A torn final
+    // record (crash mid-append) is dropped and the file rewritten. On
+    // failure missing tells a file that does not exist (safe to create)
+    // from one that cannot be opened, parsed or repaired (left untouched).
+    bool load(const std::string &path, bool *missing = nullptr);
+    // Replaces the file at path with a trie built from history. The new
+    // file is renamed over the old one, so a crash never leaves it cut short.
+    bool rebuild(const std::string &path, const std::vector<GameRecord> &history);
+    // Creates the file at path from history, like rebuild(), but only when
+    // no file exists there yet; otherwise returns false and leaves it alone.
+    bool migrate(const std::string &path, const std::vector<GameRecord> &history);
+    // False until a load or rebuild succeeds; addGame then only changes memory.
+    bool hasFile() const;
+    // Waits until the appended games have reached the disk.
+    bool sync() const;
+
+private:
+    struct Node {
+        uint32_t parent;
+        uint32_t depth;
+        int32_t row;
+        int32_t col;
+        char player;
+    };
+    struct Game {
+        uint32_t leaf;
+        uint32_t mode;
+        uint32_t winner;
+    };
+
+    // Hash-consing key: the same move from the same prefix is the same node.
+    struct Edge {
+        uint32_t parent;
+        int32_t row;
+        int32_t col;
+        char player;
+        bool operator==(const Edge &other) const {
+            return parent == other.parent && row == other.row && col == other.col && player == other.player;
+        }
+    };
+    struct EdgeHash {
+        size_t operator()(const Edge &edge) const {
+            uint64_t key = edge.parent;
+            key = key * 1000003ULL ^ static_cast<uint32_t>(edge.row);
+            key = key * 1000003ULL ^ static_cast<uint32_t>(edge.col);
+            key = key * 1000003ULL ^ static_cast<unsigned char>(edge.player);
+            return static_cast<size_t>(key ^ (key >> 32));
+        }
+    };
+
+    uint32_t internString(const std::string &text, std::string &log);
+    uint32_t childNode(uint32_t parent, const Move &m, std::string &log);
+    void insertGame(const GameRecord &record, std::string &log);
+
+    std::vector<Node> nodes;
+    std::unordered_map<Edge, uint32_t, EdgeHash> children;
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> stringIds;
+    std::vector<Game> gameList;
+    std::string filePath;
+};
+
+#endif // MOVETRIE_H
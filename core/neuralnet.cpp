@@ -0,0 +1,349 @@
+#include "neuralnet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NEURALNET_X86 1
+#include <immintrin.h>
+#endif
+
+// ------------------------------------------------------------------
+// Helper functions
+
+namespace {
+
+const char kMagic[4] = { 'T', 'T', 'N', 'N' };
+const uint32_t kVersion = 1;
+const int kMaxHidden = 1024;
+// Positions evaluated per pass of the batch kernels.
+const int kBatch = 8;
+
+// One batch for the batch kernels, each position seen from its side to
+// move: position b uses the weight columns starting at features[b * cells]
+// .. features[b * cells + counts[b] - 1] (offsets into the input weights).
+struct BatchInput {
+    const NeuralWeights *weights;
+    int cells;
+    const uint32_t *features;
+    const int *counts;
+};
+
+// Scalar kernels (reference behaviour for the SIMD versions).
+
+void addColumnScalar(float *accumulator, const float *column, int count) {
+    for (int i = 0; i < count; ++i)
+        accumulator[i] += column[i];
+}
+
+float clippedDotScalar(const float *values, const float *weights, int count) {
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i)
+        sum += std::min(std::max(values[i], 0.0f), 1.0f) * weights[i];
+    return sum;
+}
+
+void evaluateBatchScalar(const BatchInput &in, float *sums) {
+    const NeuralWeights &w = *in.weights;
+    for (int b = 0; b < kBatch; ++b) {
+        sums[b] = 0.0f;
+        const uint32_t *features = in.features + b * in.cells;
+        for (int j = 0; j < w.hidden; ++j) {
+            float acc = w.inputBias[j];
+            for (int f = 0; f < in.counts[b]; ++f)
+                acc += w.input[features[f] + j];
+            sums[b] += std::min(std::max(acc, 0.0f), 1.0f) * w.output[j];
+        }
+    }
+}
+
+#ifdef NEURALNET_X86
+
+// AVX2 kernels: 8 hidden units per register. hidden() is a multiple of 8.
+
+__attribute__((target("avx2")))
+void addColumnAvx2(float *accumulator, const float *column, int count) {
+    for (int i = 0; i < count; i += 8) {
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(accumulator + i), _mm256_loadu_ps(column + i));
+        _mm256_storeu_ps(accumulator + i, sum);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+float clippedDotAvx2(const float *values, const float *weights, int count) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 sum = zero;
+    for (int i = 0; i < count; i += 8) {
+        __m256 clipped = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(values + i), zero), one);
+        sum = _mm256_fmadd_ps(clipped, _mm256_loadu_ps(weights + i), sum);
+    }
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+}
+
+// Goes through the hidden units 8 at a time for the whole batch, so the
+// bias and output weights are loaded once per batch, the independent
+// positions keep the FMA units busy and no accumulator touches memory.
+__attribute__((target("avx2,fma")))
+void evaluateBatchAvx2(const BatchInput &in, float *sums) {
+    const NeuralWeights &w = *in.weights;
+    const float *input = w.input.data();
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 total[kBatch];
+    for (int b = 0; b < kBatch; ++b)
+        total[b] = zero;
+    for (int j = 0; j < w.hidden; j += 8) {
+        const __m256 bias = _mm256_loadu_ps(w.inputBias.data() + j);
+        const __m256 weights = _mm256_loadu_ps(w.output.data() + j);
+        for (int b = 0; b < kBatch; ++b) {
+            const uint32_t *features = in.features + b * in.cells;
+            __m256 acc = bias;
+            for (int f = 0; f < in.counts[b]; ++f)
+                acc = _mm256_add_ps(acc, _mm256_loadu_ps(input + features[f] + j));
+            total[b] = _mm256_fmadd_ps(_mm256_min_ps(_mm256_max_ps(acc, zero), one), weights, total[b]);
+        }
+    }
+    for (int b = 0; b < kBatch; ++b) {
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, total[b]);
+        sums[b] = lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+    }
+}
+
+#endif
+
+struct Kernels {
+    void (*addColumn)(float *, const float *, int);
+    float (*clippedDot)(const float *, const float *, int);
+    void (*evaluateBatch)(const BatchInput &, float *);
+    const char *name;
+};
+
+const Kernels &kernels() {
+    static const Kernels selected = []() {
+#ifdef NEURALNET_X86
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return Kernels{ addColumnAvx2, clippedDotAvx2, evaluateBatchAvx2, "avx2" };
+#endif
+        return Kernels{ addColumnScalar, clippedDotScalar, evaluateBatchScalar, "scalar" };
+    }();
+    return selected;
+}
+
+void putU32(std::ostream &out, uint32_t value) {
+    const char bytes[4] = { static_cast<char>(value), static_cast<char>(value >> 8),
+                            static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+    out.write(bytes, 4);
+}
+
+bool getU32(std::istream &in, uint32_t &value) {
+    unsigned char bytes[4];
+    if (!in.read(reinterpret_cast<char*>(bytes), 4))
+        return false;
+    value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    return true;
+}
+
+void putFloats(std::ostream &out, const float *values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t bits;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        putU32(out, bits);
+    }
+}
+
+bool getFloats(std::istream &in, float *values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t bits;
+        if (!getU32(in, bits))
+            return false;
+        std::memcpy(&values[i], &bits, sizeof(bits));
+    }
+    return true;
+}
+
+} // namespace
+
+// ------------------------------------------------------------------
+// NeuralNet Implementation
+
+NeuralNet::NeuralNet()
+    : cells(0)
+{
+    params.size = 0;
+    params.k = 0;
+    params.hidden = 0;
+    params.outputBias = 0.0f;
+}
+
+void NeuralNet::initialize(const Variant &variant, int hidden, uint64_t seed)
+{
+    params.size = variant.size;
+    params.k = variant.k;
+    params.hidden = std::min((std::max(hidden, 1) + 7) / 8 * 8, kMaxHidden);
+    cells = variant.cells;
+
+    std::mt19937_64 random(seed);
+    std::uniform_real_distribution<float> inputRange(-0.1f, 0.1f);
+    std::uniform_real_distribution<float> outputRange(-0.5f, 0.5f);
+    params.input.resize(static_cast<size_t>(2) * cells * params.hidden);
+    for (float &w : params.input)
+        w = inputRange(random);
+    params.inputBias.assign(params.hidden, 0.25f); // start inside the clipping range
+    params.output.resize(params.hidden);
+    for (float &w : params.output)
+        w = outputRange(random);
+    params.outputBias = 0.0f;
+}
+
+bool NeuralNet::load(const std::string &path, std::string *error)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t version = 0, size = 0, k = 0, hidden = 0;
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !getU32(in, version) || version != kVersion) {
+        if (error)
+            *error = path + " is not a network file";
+        return false;
+    }
+    if (!getU32(in, size) || !getU32(in, k) || !getU32(in, hidden) || makeVariant(size, k).cells == 0 ||
+        hidden == 0 || hidden % 8 != 0 || hidden > static_cast<uint32_t>(kMaxHidden)) {
+        if (error)
+            *error = path + " has an invalid header";
+        return false;
+    }
+
+    NeuralWeights loaded;
+    loaded.size = static_cast<int>(size);
+    loaded.k = static_cast<int>(k);
+    loaded.hidden = static_cast<int>(hidden);
+    const int loadedCells = loaded.size * loaded.size;
+    loaded.input.resize(static_cast<size_t>(2) * loadedCells * hidden);
+    loaded.inputBias.resize(hidden);
+    loaded.output.resize(hidden);
+    if (!getFloats(in, loaded.input.data(), loaded.input.size()) ||
+        !getFloats(in, loaded.inputBias.data(), hidden) ||
+        !getFloats(in, loaded.output.data(), hidden) ||
+        !getFloats(in, &loaded.outputBias, 1)) {
+        if (error)
+            *error = path + " is truncated";
+        return false;
+    }
+    params = loaded;
+    cells = loadedCells;
+    return true;
+}
+
+bool NeuralNet::save(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(kMagic, sizeof(kMagic));
+    putU32(out, kVersion);
+    putU32(out, static_cast<uint32_t>(params.size));
+    putU32(out, static_cast<uint32_t>(params.k));
+    putU32(out, static_cast<uint32_t>(params.hidden));
+    putFloats(out, params.input.data(), params.input.size());
+    putFloats(out, params.inputBias.data(), params.inputBias.size());
+    putFloats(out, params.output.data(), params.output.size());
+    putFloats(out, &params.outputBias, 1);
+    out.close();
+    return static_cast<bool>(out);
+}
+
+bool NeuralNet::isValid() const
+{
+    return params.hidden > 0 && cells > 0;
+}
+
+bool NeuralNet::matches(const Variant &variant) const
+{
+    return isValid() && params.size == variant.size && params.k == variant.k;
+}
+
+int NeuralNet::hidden() const
+{
+    return params.hidden;
+}
+
+NeuralWeights &NeuralNet::weights()
+{
+    return params;
+}
+
+const NeuralWeights &NeuralNet::weights() const
+{
+    return params;
+}
+
+void NeuralNet::refresh(const Position &pos, float *accumulator) const
+{
+    std::copy(params.inputBias.begin(), params.inputBias.end(), accumulator);
+    std::copy(params.inputBias.begin(), params.inputBias.end(), accumulator + params.hidden);
+    for (CellMask stones = pos.x; stones; stones &= stones - 1)
+        addStone(accumulator, lowestCell(stones), 'X');
+    for (CellMask stones = pos.o; stones; stones &= stones - 1)
+        addStone(accumulator, lowestCell(stones), 'O');
+}
+
+void NeuralNet::addStone(float *accumulator, int cell, char player) const
+{
+    // Feature cell is "own stone", cells + cell is "opponent stone".
+    const size_t h = static_cast<size_t>(params.hidden);
+    const float *own = params.input.data() + static_cast<size_t>(cell) * h;
+    const float *other = params.input.data() + static_cast<size_t>(cells + cell) * h;
+    const Kernels &k = kernels();
+    k.addColumn(accumulator, player == 'X' ? own : other, params.hidden);
+    k.addColumn(accumulator + h, player == 'O' ? own : other, params.hidden);
+}
+
+float NeuralNet::evaluate(const float *accumulator, char sideToMove) const
+{
+    const float *perspective = accumulator + (sideToMove == 'X' ? 0 : params.hidden);
+    return params.outputBias + kernels().clippedDot(perspective, params.output.data(), params.hidden);
+}
+
+float NeuralNet::evaluate(const Position &pos) const
+{
+    std::vector<float> accumulator(2 * params.hidden);
+    refresh(pos, accumulator.data());
+    return evaluate(accumulator.data(), sideToMove(pos));
+}
+
+void NeuralNet::evaluateBatch(const Position *positions, size_t count, float *result) const
+{
+    // Only the side to move's perspective is needed, so no second accumulator.
+    const uint32_t h = static_cast<uint32_t>(params.hidden);
+    std::vector<uint32_t> features(static_cast<size_t>(kBatch) * cells);
+    int counts[kBatch];
+    const Kernels &k = kernels();
+    for (size_t first = 0; first < count; first += kBatch) {
+        const int batch = static_cast<int>(std::min<size_t>(kBatch, count - first));
+        for (int b = 0; b < kBatch; ++b) {
+            counts[b] = 0;
+            if (b >= batch)
+                continue; // unused lanes see an empty board
+            const Position &pos = positions[first + b];
+            const bool xToMove = sideToMove(pos) == 'X';
+            uint32_t *list = features.data() + b * cells;
+            for (CellMask stones = xToMove ? pos.x : pos.o; stones; stones &= stones - 1)
+                list[counts[b]++] = static_cast<uint32_t>(lowestCell(stones)) * h;
+            for (CellMask stones = xToMove ? pos.o : pos.x; stones; stones &= stones - 1)
+                list[counts[b]++] = static_cast<uint32_t>(cells + lowestCell(stones)) * h;
+        }
+        float sums[kBatch];
+        k.evaluateBatch(BatchInput{ &params, cells, features.data(), counts }, sums);
+        for (int b = 0; b < batch; ++b)
+            result[first + b] = params.outputBias + sums[b];
+    }
+}
+
+const char *NeuralNet::kernelName()
+{
+    return kernels().name;
+}
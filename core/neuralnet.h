@@ -0,0 +1,72 @@
+#ifndef NEURALNET_H
+#define NEURALNET_H
+
+// Small NNUE-style position evaluator for bitboard variants, CPU only.
+//
+// Inputs are 2 * cells one-hot features seen from one side: its own stones
+// and the opponent's. A position keeps two first-layer accumulators, one
+// per perspective, so playing a stone just adds one weight column to each
+// (no full recompute during search) and the side to move only picks which
+// one to read. The accumulator is clipped to [0, 1] and a single output
+// neuron gives the value for the side to move (tanh of it approximates
+// the expected result: 1 win, 0 draw, -1 loss).
+//
+// File layout ("TTNN"): magic, version:u32, size:u32, k:u32, hidden:u32,
+// then float32 input weights [feature][hidden], input biases [hidden],
+// output weights [hidden] and the output bias, all little-endian.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bitboard.h"
+
+// --- NeuralWeights Struct Definition ---
+// Plain parameters, exposed so the trainer can update them in place.
+struct NeuralWeights {
+    int size;
+    int k;
+    int hidden;                // multiple of 8 so SIMD lanes never straddle it
+    std::vector<float> input;  // (2 * cells) x hidden
+    std::vector<float> inputBias;
+    std::vector<float> output;
+    float outputBias;
+};
+
+// --- NeuralNet Class Definition ---
+class NeuralNet
+{
+public:
+    NeuralNet();
+
+    // Random weights for a fresh network; hidden is rounded up to a multiple of 8.
+    void initialize(const Variant &variant, int hidden, uint64_t seed);
+    bool load(const std::string &path, std::string *error = nullptr);
+    bool save(const std::string &path) const;
+
+    bool isValid() const;
+    bool matches(const Variant &variant) const;
+    int hidden() const;
+    NeuralWeights &weights();
+    const NeuralWeights &weights() const;
+
+    // Accumulators hold 2 * hidden() floats: X's perspective, then O's.
+    void refresh(const Position &pos, float *accumulator) const;
+    void addStone(float *accumulator, int cell, char player) const;
+    // Raw output for the side to move; squash with tanh for a result estimate.
+    float evaluate(const float *accumulator, char sideToMove) const;
+    float evaluate(const Position &pos) const;
+    // Same as evaluate(pos) for each position, 8 per kernel pass: only the
+    // side to move's accumulator is built, in registers, and the batch shares
+    // the bias and output weight loads.
+    void evaluateBatch(const Position *positions, size_t count, float *result) const;
+
+    // Name of the kernel set in use ("avx2" or "scalar").
+    static const char *kernelName();
+
+private:
+    NeuralWeights params;
+    int cells;
+};
+
+#endif // NEURALNET_H
@@ -0,0 +1,129 @@
+#include "perft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// ------------------------------------------------------------------
+// Helper functions
+
+namespace {
+
+// Plies enumerated on the calling thread before the remaining subtrees are
+// handed to workers; enough to give every core several independent jobs.
+const int kSplitDepth = 3;
+
+void countMoves(const Variant &variant, CellMask mine, CellMask theirs, bool xToMove,
+                int ply, int maxDepth, PerftCounts *counts) {
+    CellMask empty = variant.full & ~(mine | theirs);
+    PerftCounts &here = counts[ply];
+    const bool last = ply + 1 == maxDepth;
+    while (empty) {
+        const CellMask bit = empty & (~empty + 1);
+        empty &= empty - 1;
+        const CellMask next = mine | bit;
+        here.nodes++;
+        if (hasLine(variant, next)) {
+            if (xToMove)
+                here.xWins++;
+            else
+                here.oWins++;
+        } else if ((next | theirs) == variant.full) {
+            here.draws++;
+        } else if (!last) {
+            countMoves(variant, theirs, next, !xToMove, ply + 1, maxDepth, counts);
+        }
+    }
+}
+
+bool isFinished(const Variant &variant, const Position &pos) {
+    return hasLine(variant, pos.x) || hasLine(variant, pos.o) || (pos.x | pos.o) == variant.full;
+}
+
+void enumerate(const Variant &variant, const Position &pos, int maxDepth, std::vector<PerftCounts> &counts) {
+    if (isFinished(variant, pos))
+        return;
+    const bool xToMove = sideToMove(pos) == 'X';
+    countMoves(variant, xToMove ? pos.x : pos.o, xToMove ? pos.o : pos.x, xToMove, 0, maxDepth, counts.data());
+}
+
+// Collects the unfinished positions exactly `depth` plies below pos.
+void frontier(const Variant &variant, const Position &pos, int depth, std::vector<Position> &out) {
+    if (isFinished(variant, pos))
+        return;
+    if (depth == 0) {
+        out.push_back(pos);
+        return;
+    }
+    const bool xToMove = sideToMove(pos) == 'X';
+    for (CellMask empty = emptyCells(variant, pos); empty; empty &= empty - 1) {
+        Position next = pos;
+        (xToMove ? next.x : next.o) |= empty & (~empty + 1);
+        frontier(variant, next, depth - 1, out);
+    }
+}
+
+void addCounts(std::vector<PerftCounts> &total, const std::vector<PerftCounts> &part, size_t offset) {
+    for (size_t i = 0; i < part.size() && i + offset < total.size(); ++i) {
+        total[i + offset].nodes += part[i].nodes;
+        total[i + offset].xWins += part[i].xWins;
+        total[i + offset].oWins += part[i].oWins;
+        total[i + offset].draws += part[i].draws;
+    }
+}
+
+} // namespace
+
+std::vector<PerftCounts> perft(const Variant &variant, const Position &pos, int maxDepth) {
+    std::vector<PerftCounts> counts(std::max(maxDepth, 0), PerftCounts{ 0, 0, 0, 0 });
+    if (maxDepth > 0 && variant.cells > 0)
+        enumerate(variant, pos, maxDepth, counts);
+    return counts;
+}
+
+std::vector<PerftCounts> perftParallel(const Variant &variant, const Position &pos, int maxDepth, int threads) {
+    const int split = std::min(kSplitDepth, maxDepth - 1);
+    if (threads <= 1 || split <= 0 || variant.cells == 0)
+        return perft(variant, pos, maxDepth);
+
+    // The first `split` plies are cheap: count them here, then search the
+    // subtree under every frontier position independently.
+    std::vector<PerftCounts> counts = perft(variant, pos, split);
+    counts.resize(maxDepth, PerftCounts{ 0, 0, 0, 0 });
+    std::vector<Position> jobs;
+    frontier(variant, pos, split, jobs);
+
+    std::atomic<size_t> nextJob(0);
+    std::vector<std::vector<PerftCounts>> results(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]() {
+            std::vector<PerftCounts> &local = results[t];
+            local.assign(maxDepth - split, PerftCounts{ 0, 0, 0, 0 });
+            for (size_t job = nextJob++; job < jobs.size(); job = nextJob++)
+                enumerate(variant, jobs[job], maxDepth - split, local);
+        });
+    }
+    for (auto &worker : pool)
+        worker.join();
+    for (const auto &local : results)
+        addCounts(counts, local, split);
+    return counts;
+}
+
+bool parsePosition(const Variant &variant, const std::string &text, Position &pos) {
+    if (variant.cells == 0 || static_cast<int>(text.size()) != variant.cells)
+        return false;
+    pos = Position{ 0, 0 };
+    for (int cell = 0; cell < variant.cells; ++cell) {
+        const char c = text[cell];
+        if (c == 'X' || c == 'x')
+            pos.x |= cellBit(cell);
+        else if (c == 'O' || c == 'o')
+            pos.o |= cellBit(cell);
+        else if (c != '.' && c != ' ' && c != '-')
+            return false;
+    }
+    const int balance = popCount(pos.x) - popCount(pos.o);
+    return balance == 0 || balance == 1;
+}
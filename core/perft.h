@@ -0,0 +1,34 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+// Exhaustive game-tree enumeration ("perft") for k-in-a-row variants. The
+// counts are a correctness reference for every search and move generator,
+// and the node rate a baseline for their speed.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bitboard.h"
+
+// --- PerftCounts Struct Definition ---
+// Nodes reached after exactly `ply` moves, and how many of them end the game.
+struct PerftCounts {
+    uint64_t nodes;
+    uint64_t xWins;
+    uint64_t oWins;
+    uint64_t draws;
+};
+
+// Counts for plies 1..maxDepth below pos (index 0 is ply 1). Play stops at
+// won or full boards, so later plies only continue unfinished games.
+std::vector<PerftCounts> perft(const Variant &variant, const Position &pos, int maxDepth);
+// Same counts, with the subtrees a few plies down shared out across threads.
+std::vector<PerftCounts> perftParallel(const Variant &variant, const Position &pos, int maxDepth, int threads);
+
+// Parses a row-major board of size*size characters from "XO.", e.g.
+// "X...O...." for 3x3. Returns false for wrong lengths or stone counts
+// that alternating play cannot reach.
+bool parsePosition(const Variant &variant, const std::string &text, Position &pos);
+
+#endif // PERFT_H
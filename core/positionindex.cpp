@@ -0,0 +1,263 @@
+#include "positionindex.h"
+#include "journal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+// ------------------------------------------------------------------
+// Helper functions
+
+namespace {
+
+const char kMagic[4] = { 'T', 'T', 'P', 'I' };
+const int kMaxSize = 8;
+
+// Fixed pseudo-random keys so hashes stay valid across runs and builds.
+struct ZobristKeys {
+    uint64_t value[kMaxSize * kMaxSize][2];
+    ZobristKeys() {
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (auto &cell : value) {
+            for (uint64_t &key : cell) {
+                // splitmix64
+                uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                key = z ^ (z >> 31);
+            }
+        }
+    }
+};
+
+const ZobristKeys &zobristKeys() {
+    static const ZobristKeys keys;
+    return keys;
+}
+
+// Maps (row, col) to its cell under one of the 8 symmetries of the square.
+int symmetricCell(int symmetry, int row, int col, int size) {
+    const int last = size - 1;
+    int r = row, c = col;
+    switch (symmetry) {
+    case 0: break;
+    case 1: r = col; c = last - row; break;        // rotate 90
+    case 2: r = last - row; c = last - col; break; // rotate 180
+    case 3: r = last - col; c = row; break;        // rotate 270
+    case 4: c = last - col; break;                 // mirror columns
+    case 5: r = last - row; break;                 // mirror rows
+    case 6: r = col; c = row; break;               // main diagonal
+    default: r = last - col; c = last - row; break; // anti-diagonal
+    }
+    return r * size + c;
+}
+
+char gameResult(const GameRecord &record) {
+    if (record.winner == "Draw")
+        return 'D';
+    if (record.moves.empty())
+        return '?';
+    return record.moves.back().player;
+}
+
+void positionHashes(const GameRecord &record, std::vector<uint64_t> &hashes) {
+    ZobristTracker tracker;
+    hashes.clear();
+    // Ultimate games have no 3x3 positions; they only keep their game id.
+    if (isUltimateRecord(record))
+        return;
+    hashes.push_back(tracker.canonicalHash());
+    for (const Move &m : record.moves) {
+        if (m.row < 0 || m.row >= 3 || m.col < 0 || m.col >= 3)
+            break;
+        tracker.play(m.row, m.col, m.player);
+        hashes.push_back(tracker.canonicalHash());
+    }
+}
+
+void putU64(std::string &out, uint64_t value) {
+    for (int i = 0; i < 8; ++i)
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+uint64_t getU64(const char *in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+void writeGame(std::string &out, char result, const std::vector<uint64_t> &hashes) {
+    out += result;
+    out += static_cast<char>(hashes.size());
+    for (uint64_t hash : hashes)
+        putU64(out, hash);
+}
+
+} // namespace
+
+// ------------------------------------------------------------------
+// ZobristTracker Implementation
+
+ZobristTracker::ZobristTracker(int size)
+    : size(std::min(std::max(size, 1), kMaxSize))
+{
+    reset();
+}
+
+void ZobristTracker::reset()
+{
+    std::fill(hashes, hashes + 8, 0);
+}
+
+void ZobristTracker::play(int row, int col, char player)
+{
+    const ZobristKeys &keys = zobristKeys();
+    const int side = (player == 'X') ? 0 : 1;
+    for (int s = 0; s < 8; ++s)
+        hashes[s] ^= keys.value[symmetricCell(s, row, col, size)][side];
+}
+
+uint64_t ZobristTracker::canonicalHash() const
+{
+    return *std::min_element(hashes, hashes + 8);
+}
+
+uint64_t canonicalPositionHash(const BoardState &board)
+{
+    ZobristTracker tracker(static_cast<int>(board.size()));
+    for (int row = 0; row < static_cast<int>(board.size()); ++row)
+        for (int col = 0; col < static_cast<int>(board[row].size()); ++col)
+            if (board[row][col] == 'X' || board[row][col] == 'O')
+                tracker.play(row, col, board[row][col]);
+    return tracker.canonicalHash();
+}
+
+// ------------------------------------------------------------------
+// PositionIndex Implementation
+
+PositionIndex::PositionIndex()
+{
+}
+
+void PositionIndex::clear()
+{
+    postings.clear();
+    results.clear();
+    filePath.clear();
+}
+
+size_t PositionIndex::gameCount() const
+{
+    return results.size();
+}
+
+size_t PositionIndex::memoryUsage() const
+{
+    size_t bytes = results.capacity() + filePath.capacity() + postings.bucket_count() * sizeof(void*);
+    for (const auto &posting : postings)
+        bytes += sizeof(posting) + sizeof(void*) + posting.second.occurrences.capacity() * sizeof(PositionOccurrence);
+    return bytes;
+}
+
+void PositionIndex::indexHashes(char result, const std::vector<uint64_t> &hashes)
+{
+    const uint32_t game = static_cast<uint32_t>(results.size());
+    for (size_t ply = 0; ply < hashes.size(); ++ply) {
+        Posting &posting = postings[hashes[ply]];
+        if (posting.occurrences.empty())
+            posting.stats = PositionStats{ 0, 0, 0, 0 };
+        posting.occurrences.push_back(PositionOccurrence{ game, static_cast<uint16_t>(ply) });
+        posting.stats.games++;
+        if (result == 'X')
+            posting.stats.xWins++;
+        else if (result == 'O')
+            posting.stats.oWins++;
+        else if (result == 'D')
+            posting.stats.draws++;
+    }
+    results.push_back(result);
+}
+
+bool PositionIndex::addGame(const GameRecord &record)
+{
+    std::vector<uint64_t> hashes;
+    positionHashes(record, hashes);
+    char result = gameResult(record);
+    indexHashes(result, hashes);
+    if (filePath.empty())
+        return true;
+    std::string bytes;
+    writeGame(bytes, result, hashes);
+    if (appendToFile(filePath, bytes))
+        return true;
+    // Later games would be misnumbered in the file; stop appending.
+    filePath.clear();
+    return false;
+}
+
+std::vector<PositionOccurrence> PositionIndex::gamesReaching(const BoardState &board) const
+{
+    auto it = postings.find(canonicalPositionHash(board));
+    if (it == postings.end())
+        return std::vector<PositionOccurrence>();
+    return it->second.occurrences;
+}
+
+PositionStats PositionIndex::statsFrom(const BoardState &board) const
+{
+    auto it = postings.find(canonicalPositionHash(board));
+    if (it == postings.end())
+        return PositionStats{ 0, 0, 0, 0 };
+    return it->second.stats;
+}
+
+// File layout: "TTPI", then per game one result byte, one count byte and
+// count little-endian 64-bit hashes (ply 0 first).
+bool PositionIndex::load(const std::string &path)
+{
+    clear();
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(kMagic) || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0)
+        return false;
+
+    std::vector<uint64_t> hashes;
+    size_t pos = sizeof(kMagic);
+    while (pos < data.size()) {
+        const size_t count = pos + 2 <= data.size() ? static_cast<unsigned char>(data[pos + 1]) : 0;
+        // A torn final record (crash mid-append) means the file must be rebuilt.
+        if (pos + 2 + count * 8 > data.size()) {
+            clear();
+            return false;
+        }
+        const char result = data[pos];
+        pos += 2;
+        hashes.resize(count);
+        for (size_t i = 0; i < count; ++i, pos += 8)
+            hashes[i] = getU64(data.data() + pos);
+        indexHashes(result, hashes);
+    }
+    filePath = path;
+    return true;
+}
+
+bool PositionIndex::rebuild(const std::string &path, const std::vector<GameRecord> &history)
+{
+    clear();
+    std::string bytes(kMagic, sizeof(kMagic));
+    std::vector<uint64_t> hashes;
+    for (const GameRecord &record : history) {
+        positionHashes(record, hashes);
+        char result = gameResult(record);
+        indexHashes(result, hashes);
+        writeGame(bytes, result, hashes);
+    }
+    if (!replaceFileAtomically(path, bytes))
+        return false;
+    filePath = path;
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef POSITIONINDEX_H
+#define POSITIONINDEX_H
+
+// Inverted index from board positions to the games that reached them.
+// Positions are keyed by a Zobrist hash reduced over the 8 symmetries of
+// the square board, so rotated and mirrored positions share an entry.
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gamecore.h"
+
+// --- PositionOccurrence Struct Definition ---
+// A game id (its index in the history) and the number of moves played.
+struct PositionOccurrence {
+    uint32_t game;
+    uint16_t ply;
+};
+
+// --- PositionStats Struct Definition ---
+// Final results of the games that passed through a position.
+struct PositionStats {
+    int games;
+    int xWins;
+    int oWins;
+    int draws;
+};
+
+// --- ZobristTracker Class Definition ---
+// Keeps the hash of a position under all 8 symmetries while moves are
+// played, so the canonical hash costs 8 xors per move.
+class ZobristTracker
+{
+public:
+    explicit ZobristTracker(int size = 3);
+    void reset();
+    void play(int row, int col, char player);
+    uint64_t canonicalHash() const;
+
+private:
+    int size;
+    uint64_t hashes[8];
+};
+
+uint64_t canonicalPositionHash(const BoardState &board);
+
+// --- PositionIndex Class Definition ---
+// Game ids are assigned in the order games are added, matching the order of
+// MainWindow::gameHistory. The file is an append-only log of hashed games.
+class PositionIndex
+{
+public:
+    PositionIndex();
+
+    void clear();
+    size_t gameCount() const;
+    // Approximate heap bytes held, for cache accounting.
+    size_t memoryUsage() const;
+    // Adds a game in memory and, if a file is attached, appends it there.
+    // If the append fails the game stays indexed in memory but the file is
+    // detached and false returned; rebuild() it from the history.
+    bool addGame(const GameRecord &record);
+
+    std::vector<PositionOccurrence> gamesReaching(const BoardState &board) const;
+    PositionStats statsFrom(const BoardState &board) const;
+
+    // Loads the index stored at path and keeps appending to it. Returns
+    // false for a missing or damaged file, which should then be rebuilt.
+    bool load(const std::string &path);
+    // Replaces the file at path with the index built from history.
+    bool rebuild(const std::string &path, const std::vector<GameRecord> &history);
+
+private:
+    struct Posting {
+        std::vector<PositionOccurrence> occurrences;
+        PositionStats stats; // kept up to date so statsFrom is one lookup
+    };
+
+    void indexHashes(char result, const std::vector<uint64_t> &hashes);
+
+    std::unordered_map<uint64_t, Posting> postings;
+    std::vector<char> results; // 'X', 'O', 'D' or '?' per game
+    std::string filePath;
+};
+
+#endif // POSITIONINDEX_H
@@ -0,0 +1,304 @@
+#include "proofsearch.h"
+
+#include <algorithm>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Proof and disproof numbers saturate here, so sums cannot overflow.
+const uint32_t kInfinity = 1u << 30;
+const int kBucketSize = 4;
+
+uint32_t addSaturated(uint32_t a, uint32_t b) {
+    return std::min(a + b, kInfinity);
+}
+
+uint64_t positionHash(CellMask x, CellMask o, uint32_t tag) {
+    uint64_t h = x * 0x9E3779B97F4A7C15ULL ^ (o + tag) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 29);
+}
+
+// What the lines mean to the side to move (`mine`): empty cells where it
+// completes a line, where the opponent would (so it must block), and where
+// it makes a new threat (a line one stone short afterwards).
+struct LineScan {
+    CellMask wins;
+    CellMask blocks;
+    CellMask threats;
+};
+
+LineScan scanLines(const Variant &variant, CellMask mine, CellMask theirs) {
+    const CellMask empty = variant.full & ~(mine | theirs);
+    LineScan scan = { 0, 0, 0 };
+    for (CellMask line : variant.lines) {
+        if (!(line & theirs)) {
+            const int stones = popCount(line & mine);
+            if (stones == variant.k - 1)
+                scan.wins |= line & empty;
+            else if (stones == variant.k - 2)
+                scan.threats |= line & empty;
+        } else if (!(line & mine) && popCount(line & theirs) == variant.k - 1) {
+            scan.blocks |= line & empty;
+        }
+    }
+    return scan;
+}
+
+} // namespace
+
+const char *proofValueName(int value) {
+    switch (value) {
+    case PROOF_WIN: return "win";
+    case PROOF_DRAW: return "draw";
+    case PROOF_LOSS: return "loss";
+    default: return "unknown";
+    }
+}
+
+// ------------------------------------------------------------------
+// ProofSolver Implementation
+
+ProofSolver::ProofSolver(size_t tableBytes)
+    : used(0), variant(nullptr), attacker('X'), threatsOnly(false), tag(0), nodes(0), maxNodes(0),
+      timed(false), aborted(false), rootCell(-1)
+{
+    setTableBytes(tableBytes);
+}
+
+void ProofSolver::setTableBytes(size_t bytes)
+{
+    size_t buckets = 0;
+    if (bytes >= kBucketSize * sizeof(Entry)) {
+        buckets = 1;
+        while (buckets * 2 <= bytes / (kBucketSize * sizeof(Entry)))
+            buckets *= 2;
+    }
+    if (buckets * kBucketSize == table.size()) {
+        clear();
+        return;
+    }
+    std::vector<Entry>().swap(table);
+    table.assign(buckets * kBucketSize, Entry{ 0, 0, 0, 0, 0, 0 });
+    used = 0;
+}
+
+size_t ProofSolver::tableBytes() const
+{
+    return table.size() * sizeof(Entry);
+}
+
+size_t ProofSolver::tableEntries() const
+{
+    return table.size();
+}
+
+size_t ProofSolver::tableUsed() const
+{
+    return used;
+}
+
+void ProofSolver::clear()
+{
+    std::fill(table.begin(), table.end(), Entry{ 0, 0, 0, 0, 0, 0 });
+    used = 0;
+}
+
+const ProofSolver::Entry *ProofSolver::find(CellMask x, CellMask o) const
+{
+    const size_t bucket = (positionHash(x, o, tag) & (table.size() / kBucketSize - 1)) * kBucketSize;
+    for (int i = 0; i < kBucketSize; ++i) {
+        const Entry &entry = table[bucket + i];
+        if (entry.tag == tag && entry.x == x && entry.o == o)
+            return &entry;
+    }
+    return nullptr;
+}
+
+void ProofSolver::store(CellMask x, CellMask o, uint32_t pn, uint32_t dn, uint64_t work)
+{
+    const size_t bucket = (positionHash(x, o, tag) & (table.size() / kBucketSize - 1)) * kBucketSize;
+    // The same position, else an empty slot, else the entry that cost least.
+    Entry *slot = &table[bucket];
+    for (int i = 0; i < kBucketSize; ++i) {
+        Entry &entry = table[bucket + i];
+        if (entry.tag == tag && entry.x == x && entry.o == o) {
+            slot = &entry;
+            break;
+        }
+        if (slot->tag != 0 && (entry.tag == 0 || entry.work < slot->work))
+            slot = &entry;
+    }
+    if (slot->tag == 0)
+        ++used;
+    *slot = Entry{ x, o, pn, dn, static_cast<uint32_t>(std::min<uint64_t>(work, UINT32_MAX)), tag };
+}
+
+bool ProofSolver::outOfBudget()
+{
+    if (maxNodes > 0 && nodes >= maxNodes)
+        aborted = true;
+    // Checking the clock every node would cost more than the node itself.
+    if (timed && (nodes & 1023) == 0 && Clock::now() >= deadline)
+        aborted = true;
+    return aborted;
+}
+
+// Expands the node until its proof number reaches thresholdPn or its
+// disproof number reaches thresholdDn (Nagai's MID), then stores them.
+// The attacker is proving at OR nodes, the defender refuting at AND nodes.
+void ProofSolver::mid(CellMask x, CellMask o, uint32_t thresholdPn, uint32_t thresholdDn, int ply)
+{
+    if (outOfBudget())
+        return;
+    ++nodes;
+    const bool xToMove = popCount(x) == popCount(o);
+    const CellMask mine = xToMove ? x : o;
+    const CellMask theirs = xToMove ? o : x;
+    const bool orNode = (xToMove ? 'X' : 'O') == attacker;
+    const CellMask empty = variant->full & ~(x | o);
+
+    // Nodes decided without expanding: a full board, a line next move, or
+    // two opponent lines next move that cannot both be blocked.
+    const LineScan scan = scanLines(*variant, mine, theirs);
+    int outcome = 0; // 1 = attacker wins, -1 = attacker does not
+    if (empty == 0)
+        outcome = -1;
+    else if (scan.wins)
+        outcome = orNode ? 1 : -1;
+    else if (popCount(scan.blocks) >= 2)
+        outcome = orNode ? -1 : 1;
+    // A blocked threat must be answered; otherwise the attacker of a
+    // threat-space pass only plays threats and the defender anything.
+    const CellMask candidates = scan.blocks ? scan.blocks : ((orNode && threatsOnly) ? scan.threats : empty);
+    if (outcome == 0 && candidates == 0)
+        outcome = -1;
+    if (outcome != 0) {
+        if (ply == 0 && outcome == 1 && orNode)
+            rootCell = lowestCell(scan.wins);
+        store(x, o, outcome > 0 ? 0 : kInfinity, outcome > 0 ? kInfinity : 0, 1);
+        return;
+    }
+
+    int cells[64];
+    int count = 0;
+    for (CellMask rest = candidates; rest; rest &= rest - 1)
+        cells[count++] = lowestCell(rest);
+
+    const uint64_t startNodes = nodes;
+    uint32_t pn = 1;
+    uint32_t dn = 1;
+    int bestIndex = 0;
+    while (true) {
+        // OR nodes take the smallest child proof number and the sum of the
+        // disproof numbers; AND nodes the other way round.
+        uint32_t best = kInfinity + 1;
+        uint32_t second = kInfinity;
+        uint32_t bestOther = 0;
+        uint32_t sum = 0;
+        for (int i = 0; i < count; ++i) {
+            const CellMask bit = cellBit(cells[i]);
+            const Entry *child = find(xToMove ? x | bit : x, xToMove ? o : o | bit);
+            const uint32_t childPn = child ? child->pn : 1;
+            const uint32_t childDn = child ? child->dn : 1;
+            const uint32_t key = orNode ? childPn : childDn;
+            const uint32_t other = orNode ? childDn : childPn;
+            sum = addSaturated(sum, other);
+            if (key < best) {
+                second = std::min(best, kInfinity);
+                best = key;
+                bestOther = other;
+                bestIndex = i;
+            } else if (key < second) {
+                second = key;
+            }
+        }
+        pn = orNode ? best : sum;
+        dn = orNode ? sum : best;
+        if (pn >= thresholdPn || dn >= thresholdDn)
+            break;
+
+        uint32_t childThresholdPn;
+        uint32_t childThresholdDn;
+        if (orNode) {
+            childThresholdPn = std::min(thresholdPn, addSaturated(second, 1));
+            childThresholdDn = thresholdDn - dn + bestOther;
+        } else {
+            childThresholdPn = thresholdPn - pn + bestOther;
+            childThresholdDn = std::min(thresholdDn, addSaturated(second, 1));
+        }
+        const CellMask bit = cellBit(cells[bestIndex]);
+        mid(xToMove ? x | bit : x, xToMove ? o : o | bit, childThresholdPn, childThresholdDn, ply + 1);
+        if (aborted)
+            return;
+    }
+    if (ply == 0 && orNode && pn == 0)
+        rootCell = cells[bestIndex];
+    store(x, o, pn, dn, nodes - startNodes + 1);
+}
+
+ProofSolver::PassResult ProofSolver::prove(const Position &pos, char side, bool threats)
+{
+    attacker = side;
+    threatsOnly = threats;
+    tag = 0x80000000u | static_cast<uint32_t>(variant->size) << 16 | static_cast<uint32_t>(variant->k) << 8 |
+          (side == 'O' ? 2u : 0u) | (threats ? 1u : 0u);
+    rootCell = -1;
+    mid(pos.x, pos.o, kInfinity, kInfinity, 0);
+    const Entry *root = aborted ? nullptr : find(pos.x, pos.o);
+    if (root && root->pn == 0)
+        return PASS_PROVEN;
+    if (root && root->dn == 0)
+        return PASS_DISPROVEN;
+    return PASS_UNKNOWN;
+}
+
+ProofResult ProofSolver::solve(const Variant &var, const Position &pos, uint64_t nodeLimit, int timeMs)
+{
+    ProofResult result = { PROOF_UNKNOWN, -1, 0 };
+    if (var.cells == 0 || table.empty() || (pos.x & pos.o) || ((pos.x | pos.o) & ~var.full))
+        return result;
+    const char mover = sideToMove(pos);
+    const char opponent = mover == 'X' ? 'O' : 'X';
+    if (hasLine(var, mover == 'X' ? pos.x : pos.o))
+        return result; // cannot happen in a real game
+    if (hasLine(var, mover == 'X' ? pos.o : pos.x)) {
+        result.value = PROOF_LOSS;
+        return result;
+    }
+    if (emptyCells(var, pos) == 0) {
+        result.value = PROOF_DRAW;
+        return result;
+    }
+
+    variant = &var;
+    nodes = 0;
+    maxNodes = nodeLimit;
+    aborted = false;
+    timed = timeMs > 0;
+    deadline = Clock::now() + std::chrono::milliseconds(timeMs);
+
+    // Threat space first: cheap, and where most wins on large boards are.
+    if (prove(pos, mover, true) == PASS_PROVEN) {
+        result.value = PROOF_WIN;
+        result.cell = rootCell;
+    } else if (!aborted && prove(pos, opponent, true) == PASS_PROVEN) {
+        result.value = PROOF_LOSS;
+    } else if (!aborted) {
+        const PassResult win = prove(pos, mover, false);
+        if (win == PASS_PROVEN) {
+            result.value = PROOF_WIN;
+            result.cell = rootCell;
+        } else if (win == PASS_DISPROVEN) {
+            const PassResult loss = prove(pos, opponent, false);
+            if (loss == PASS_PROVEN)
+                result.value = PROOF_LOSS;
+            else if (loss == PASS_DISPROVEN)
+                result.value = PROOF_DRAW;
+        }
+    }
+    result.nodes = nodes;
+    return result;
+}
@@ -0,0 +1,98 @@
+#ifndef PROOFSEARCH_H
+#define PROOFSEARCH_H
+
+// Depth-first proof-number search (df-pn) for k-in-a-row variants. It has
+// no depth limit, so forced wins far beyond the horizon of searchMove are
+// proven as soon as the few nodes on the winning threat sequence are seen.
+//
+// Every pass answers "can attacker force a line?". The first pass only
+// lets the attacker play threats (moves after which one more stone makes
+// a line), so every defender reply is a forced block and the tree stays
+// narrow; a proof there is a real proof, a failure proves nothing. Full
+// width passes follow in the remaining budget, and asking the question
+// for both sides also proves draws on boards small enough to exhaust.
+//
+// Proof and disproof numbers live in a fixed-size transposition table
+// that keeps the entries with the most work behind them, so memory stays
+// bounded however long the search runs.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitboard.h"
+
+// Values are from the point of view of the side to move.
+enum ProofValue {
+    PROOF_UNKNOWN = 0, // not proven within the budget
+    PROOF_LOSS = 1,
+    PROOF_DRAW = 2,
+    PROOF_WIN = 3
+};
+
+// --- ProofResult Struct Definition ---
+struct ProofResult {
+    int value;      // ProofValue
+    int cell;       // a winning move for PROOF_WIN, otherwise -1
+    uint64_t nodes; // positions expanded, over all passes
+};
+
+const size_t kDefaultProofTableBytes = 16 << 20;
+
+const char *proofValueName(int value);
+
+// --- ProofSolver Class Definition ---
+// One solver per thread. The table is kept between calls, so consecutive
+// positions of a game reuse what earlier searches proved; solve() itself
+// never allocates.
+class ProofSolver
+{
+public:
+    explicit ProofSolver(size_t tableBytes = kDefaultProofTableBytes);
+
+    // Reallocates and empties the table, rounded down to whole buckets of
+    // entries (a power of two of them).
+    void setTableBytes(size_t bytes);
+    size_t tableBytes() const;   // memory held by the table
+    size_t tableEntries() const; // capacity
+    size_t tableUsed() const;    // entries filled so far
+    void clear();
+
+    // Budgets of 0 mean no limit. pos must be reachable by alternating play.
+    ProofResult solve(const Variant &variant, const Position &pos, uint64_t maxNodes, int timeMs = 0);
+
+private:
+    struct Entry {
+        CellMask x;
+        CellMask o;
+        uint32_t pn;
+        uint32_t dn;
+        uint32_t work; // nodes expanded below the entry, for replacement
+        uint32_t tag;  // variant and pass; 0 marks an empty slot
+    };
+    enum PassResult { PASS_PROVEN, PASS_DISPROVEN, PASS_UNKNOWN };
+
+    PassResult prove(const Position &pos, char side, bool threats);
+    void mid(CellMask x, CellMask o, uint32_t thresholdPn, uint32_t thresholdDn, int ply);
+    const Entry *find(CellMask x, CellMask o) const;
+    void store(CellMask x, CellMask o, uint32_t pn, uint32_t dn, uint64_t work);
+    bool outOfBudget();
+
+    std::vector<Entry> table;
+    size_t used;
+
+    // State of the current pass.
+    const Variant *variant;
+    char attacker;
+    bool threatsOnly;
+    uint32_t tag;
+    uint64_t nodes;
+    uint64_t maxNodes;
+    bool timed;
+    bool aborted;
+    std::chrono::steady_clock::time_point deadline;
+    int rootCell;
+};
+
+#endif // PROOFSEARCH_H
@@ -0,0 +1,239 @@
+#include "search.h"
+#include "neuralnet.h"
+#include "proofsearch.h"
+#include "tablebase.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// ------------------------------------------------------------------
+// Helper functions
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct SearchContext {
+    const Variant *variant;
+    const EngineConfig *config;
+    int order[64];        // cells, centre first
+    int orderSize;
+    Clock::time_point deadline;
+    bool timed;
+    bool aborted;
+    uint64_t nodes;
+    // With a network: one accumulator pair per ply, updated a stone at a time.
+    const NeuralNet *network;
+    float *accumulators;
+    int accumulatorSize;
+};
+
+int lineWeight(int stones) {
+    return stones == 0 ? 0 : 1 << (3 * (stones - 1));
+}
+
+void centreOrder(const Variant &variant, int *order, int &size) {
+    size = variant.cells;
+    for (int cell = 0; cell < size; ++cell)
+        order[cell] = cell;
+    const int twiceCentre = variant.size - 1;
+    std::stable_sort(order, order + size, [&](int a, int b) {
+        const int da = std::abs(2 * (a / variant.size) - twiceCentre) + std::abs(2 * (a % variant.size) - twiceCentre);
+        const int db = std::abs(2 * (b / variant.size) - twiceCentre) + std::abs(2 * (b % variant.size) - twiceCentre);
+        return da < db;
+    });
+}
+
+int evaluateSides(const Variant &variant, CellMask mine, CellMask theirs) {
+    int score = 0;
+    for (CellMask line : variant.lines) {
+        const int own = popCount(line & mine);
+        const int other = popCount(line & theirs);
+        if (other == 0)
+            score += lineWeight(own);
+        else if (own == 0)
+            score -= lineWeight(other);
+    }
+    return score;
+}
+
+bool outOfTime(SearchContext &ctx) {
+    // Checking the clock every node would cost more than the search itself.
+    if (ctx.timed && (ctx.nodes & 1023) == 0 && Clock::now() >= ctx.deadline)
+        ctx.aborted = true;
+    return ctx.aborted;
+}
+
+// X moves first, so the side to move is X exactly when the counts match.
+char moverOf(CellMask mine, CellMask theirs) {
+    return popCount(mine) == popCount(theirs) ? 'X' : 'O';
+}
+
+// Fills the accumulators of ply + 1 from those of ply plus one stone.
+void pushStone(SearchContext &ctx, int ply, int cell, char player) {
+    const float *parent = ctx.accumulators + static_cast<size_t>(ply) * ctx.accumulatorSize;
+    float *child = ctx.accumulators + static_cast<size_t>(ply + 1) * ctx.accumulatorSize;
+    std::copy(parent, parent + ctx.accumulatorSize, child);
+    ctx.network->addStone(child, cell, player);
+}
+
+// Negamax from the point of view of `mine`, the side to move. `theirs`
+// made the last move, so only they can have just completed a line.
+int negamax(SearchContext &ctx, CellMask mine, CellMask theirs, int depth, int ply, int alpha, int beta) {
+    ctx.nodes++;
+    const Variant &variant = *ctx.variant;
+    if (hasLine(variant, theirs))
+        return -(kSearchWinScore - ply);
+    if ((mine | theirs) == variant.full)
+        return 0;
+    if (depth == 0) {
+        if (!ctx.network)
+            return evaluateSides(variant, mine, theirs);
+        const float *accumulator = ctx.accumulators + static_cast<size_t>(ply) * ctx.accumulatorSize;
+        return networkScore(ctx.network->evaluate(accumulator, moverOf(mine, theirs)));
+    }
+    if (outOfTime(ctx))
+        return 0;
+    const char mover = ctx.network ? moverOf(mine, theirs) : 'X';
+
+    int best = -kSearchWinScore - 1;
+    for (int i = 0; i < ctx.orderSize; ++i) {
+        const CellMask bit = cellBit(ctx.order[i]);
+        if ((mine | theirs) & bit)
+            continue;
+        if (ctx.network)
+            pushStone(ctx, ply, ctx.order[i], mover);
+        const int score = -negamax(ctx, theirs, mine | bit, depth - 1, ply + 1, -beta, -alpha);
+        if (ctx.aborted)
+            return 0;
+        best = std::max(best, score);
+        if (ctx.config->alphaBeta) {
+            alpha = std::max(alpha, score);
+            if (alpha >= beta)
+                break;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int evaluatePosition(const Variant &variant, const Position &pos) {
+    const bool xToMove = sideToMove(pos) == 'X';
+    return evaluateSides(variant, xToMove ? pos.x : pos.o, xToMove ? pos.o : pos.x);
+}
+
+int networkScore(float output) {
+    const float clamped = std::min(std::max(output, -100.0f), 100.0f);
+    return static_cast<int>(std::lround(clamped * 1000.0f));
+}
+
+SearchResult searchMove(const Variant &variant, const Position &pos, const EngineConfig &config) {
+    SearchResult result = { -1, 0, 0, 0, PROOF_UNKNOWN, 0 };
+    const bool xToMove = sideToMove(pos) == 'X';
+    const CellMask mine = xToMove ? pos.x : pos.o;
+    const CellMask theirs = xToMove ? pos.o : pos.x;
+    const CellMask empty = emptyCells(variant, pos);
+    if (variant.cells == 0 || empty == 0 || hasLine(variant, pos.x) || hasLine(variant, pos.o))
+        return result;
+
+    // A solved variant needs no search: the tablebase move is perfect play.
+    const Tablebase *table = config.tablebase;
+    if (table && table->isOpen() && table->variant().size == variant.size && table->variant().k == variant.k) {
+        int value = TB_INVALID;
+        const int cell = table->bestMove(pos, &value);
+        if (cell >= 0) {
+            const int win = kSearchWinScore - variant.cells;
+            result.cell = cell;
+            result.score = value == TB_WIN ? win : (value == TB_LOSS ? -win : 0);
+            result.proof = value == TB_WIN ? PROOF_WIN : (value == TB_LOSS ? PROOF_LOSS : PROOF_DRAW);
+            return result;
+        }
+    }
+
+    // A proven win is played at once; a proven loss or draw still needs the
+    // search to pick the move.
+    if (config.proofNodes > 0) {
+        // One solver per thread, so its table carries over between moves.
+        thread_local ProofSolver prover(0);
+        thread_local size_t proverBytes = 0;
+        const size_t bytes = config.proofTableBytes ? config.proofTableBytes : kDefaultProofTableBytes;
+        if (bytes != proverBytes) {
+            prover.setTableBytes(bytes);
+            proverBytes = bytes;
+        }
+        const ProofResult proof = prover.solve(variant, pos, config.proofNodes);
+        result.proof = proof.value;
+        result.proofNodes = proof.nodes;
+        if (proof.value == PROOF_WIN) {
+            result.cell = proof.cell;
+            result.score = kSearchWinScore - variant.cells;
+            return result;
+        }
+    }
+
+    SearchContext ctx;
+    ctx.variant = &variant;
+    ctx.config = &config;
+    centreOrder(variant, ctx.order, ctx.orderSize);
+    ctx.timed = false;
+    ctx.aborted = false;
+    ctx.nodes = 0;
+    ctx.network = config.network && config.network->matches(variant) ? config.network : nullptr;
+    ctx.accumulators = nullptr;
+    ctx.accumulatorSize = 0;
+    std::vector<float> accumulators;
+    if (ctx.network) {
+        ctx.accumulatorSize = 2 * ctx.network->hidden();
+        accumulators.resize(static_cast<size_t>(popCount(empty) + 1) * ctx.accumulatorSize);
+        ctx.accumulators = accumulators.data();
+        ctx.network->refresh(pos, ctx.accumulators);
+    }
+
+    const int maxDepth = std::min(std::max(config.depth, 1), popCount(empty));
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        // Depth 1 always finishes so there is a move to play.
+        if (depth == 2 && config.timeMs > 0) {
+            ctx.timed = true;
+            ctx.deadline = Clock::now() + std::chrono::milliseconds(config.timeMs);
+        }
+
+        // Root: try the previous iteration's best move first.
+        int order[64];
+        int count = 0;
+        if (result.cell >= 0)
+            order[count++] = result.cell;
+        for (int i = 0; i < ctx.orderSize; ++i)
+            if ((empty & cellBit(ctx.order[i])) && ctx.order[i] != result.cell)
+                order[count++] = ctx.order[i];
+
+        int bestCell = -1;
+        int bestScore = -kSearchWinScore - 1;
+        int alpha = -kSearchWinScore - 1;
+        const int beta = kSearchWinScore + 1;
+        for (int i = 0; i < count && !ctx.aborted; ++i) {
+            if (ctx.network)
+                pushStone(ctx, 0, order[i], xToMove ? 'X' : 'O');
+            const int score = -negamax(ctx, theirs, mine | cellBit(order[i]), depth - 1, 1, -beta, -alpha);
+            if (!ctx.aborted && score > bestScore) {
+                bestScore = score;
+                bestCell = order[i];
+            }
+            if (config.alphaBeta)
+                alpha = std::max(alpha, bestScore);
+        }
+        if (ctx.aborted)
+            break;
+        result.cell = bestCell;
+        result.score = bestScore;
+        result.depth = depth;
+        // A proven result cannot change with more depth.
+        if (std::abs(bestScore) >= kSearchWinScore - variant.cells)
+            break;
+    }
+    result.nodes = ctx.nodes;
+    return result;
+}
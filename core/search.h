@@ -0,0 +1,53 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+// Configurable game-tree search for k-in-a-row variants: depth-limited
+// negamax with iterative deepening, an optional time budget and optional
+// alpha-beta pruning, so engine settings can be compared for strength
+// against cost. A tablebase (tablebase.h) answers solved variants with a
+// perfect move outright, and a proof-number search (proofsearch.h) can run
+// first and play a forced win without searching.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "bitboard.h"
+
+class NeuralNet;
+class Tablebase;
+
+// --- EngineConfig Struct Definition ---
+struct EngineConfig {
+    std::string name;
+    int depth;      // plies searched at most (full width)
+    int timeMs;     // budget per move, 0 = none; the last finished depth is used
+    bool alphaBeta; // false searches every node of the depth-limited tree
+    const NeuralNet *network; // horizon evaluator, nullptr = line counting
+    uint64_t proofNodes;      // df-pn budget before the search, 0 = none
+    size_t proofTableBytes;   // its transposition table, 0 = kDefaultProofTableBytes
+    const Tablebase *tablebase; // probed instead of searching when it matches the variant, nullptr = none
+};
+
+// --- SearchResult Struct Definition ---
+struct SearchResult {
+    int cell;       // -1 when the board is full or already decided
+    int score;      // side to move's view; |score| >= kSearchWinScore - cells is a forced result
+    int depth;      // deepest iteration that finished
+    uint64_t nodes; // positions visited, including unfinished iterations
+    int proof;      // ProofValue for the side to move, PROOF_UNKNOWN if not proven
+    uint64_t proofNodes;
+};
+
+const int kSearchWinScore = 1000000;
+
+// Heuristic value of pos for the side to move: lines still open for one
+// side only, weighted steeply by how many stones they already hold.
+int evaluatePosition(const Variant &variant, const Position &pos);
+
+// Network output scaled to search units and kept well below kSearchWinScore.
+int networkScore(float output);
+
+SearchResult searchMove(const Variant &variant, const Position &pos, const EngineConfig &config);
+
+#endif // SEARCH_H
@@ -0,0 +1,420 @@
+#include "tablebase.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ------------------------------------------------------------------
+// Helper functions for position indexing
+
+namespace {
+
+struct TablebaseHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t size;
+    uint32_t k;
+    uint32_t layerCount;
+    uint32_t reserved;
+};
+
+const char kMagic[4] = { 'T', 'T', 'T', 'B' };
+const uint32_t kVersion = 1;
+
+struct BinomialTable {
+    uint64_t value[65][65];
+    BinomialTable() {
+        std::memset(value, 0, sizeof(value));
+        for (int i = 0; i <= 64; ++i) {
+            value[i][0] = 1;
+            for (int j = 1; j <= i; ++j)
+                value[i][j] = value[i - 1][j - 1] + (j < i ? value[i - 1][j] : 0);
+        }
+    }
+};
+
+uint64_t binom(int n, int r) {
+    static const BinomialTable table; // initialised once, thread-safe
+    if (r < 0 || n < 0 || r > n)
+        return 0;
+    return table.value[n][r];
+}
+
+inline int xCountForLayer(int stones) { return (stones + 1) / 2; }
+
+uint64_t layerEntries(int cells, int stones) {
+    return binom(cells, stones) * binom(stones, xCountForLayer(stones));
+}
+
+inline uint64_t layerWords(uint64_t entries) { return (entries + 31) / 32; }
+
+// Colexicographic rank of a set among all sets of the same size.
+uint64_t rankSubset(CellMask mask) {
+    uint64_t rank = 0;
+    int j = 0;
+    while (mask) {
+        int i = lowestCell(mask);
+        mask &= mask - 1;
+        rank += binom(i, ++j);
+    }
+    return rank;
+}
+
+CellMask unrankSubset(uint64_t rank, int n, int count) {
+    CellMask mask = 0;
+    for (int j = count; j >= 1; --j) {
+        int i = j - 1;
+        while (i + 1 < n && binom(i + 1, j) <= rank)
+            ++i;
+        mask |= cellBit(i);
+        rank -= binom(i, j);
+        n = i;
+    }
+    return mask;
+}
+
+// Packs the bits of stones that fall on occupied cells next to each other.
+CellMask compressOnto(CellMask stones, CellMask occupied) {
+    CellMask pattern = 0;
+    for (int t = 0; occupied; ++t) {
+        CellMask bit = occupied & (~occupied + 1);
+        if (stones & bit)
+            pattern |= cellBit(t);
+        occupied &= occupied - 1;
+    }
+    return pattern;
+}
+
+CellMask expandOnto(CellMask pattern, CellMask occupied) {
+    CellMask stones = 0;
+    for (int t = 0; occupied; ++t) {
+        CellMask bit = occupied & (~occupied + 1);
+        if (pattern & cellBit(t))
+            stones |= bit;
+        occupied &= occupied - 1;
+    }
+    return stones;
+}
+
+// Returns false for positions whose stone counts cannot come from alternating play.
+bool positionIndex(const Position &pos, int &layer, uint64_t &index) {
+    CellMask occupied = pos.x | pos.o;
+    layer = popCount(occupied);
+    int xCount = xCountForLayer(layer);
+    if ((pos.x & pos.o) || popCount(pos.x) != xCount)
+        return false;
+    index = rankSubset(occupied) * binom(layer, xCount) + rankSubset(compressOnto(pos.x, occupied));
+    return true;
+}
+
+Position positionAt(int cells, int layer, uint64_t index) {
+    int xCount = xCountForLayer(layer);
+    uint64_t patterns = binom(layer, xCount);
+    CellMask occupied = unrankSubset(index / patterns, cells, layer);
+    Position pos;
+    pos.x = expandOnto(unrankSubset(index % patterns, layer, xCount), occupied);
+    pos.o = occupied & ~pos.x;
+    return pos;
+}
+
+inline int readValue(const uint64_t *words, uint64_t index) {
+    return static_cast<int>((words[index >> 5] >> ((index & 31) * 2)) & 3);
+}
+
+inline int childValue(const uint64_t *nextLayer, const Position &child) {
+    int layer;
+    uint64_t index;
+    if (!positionIndex(child, layer, index))
+        return TB_INVALID;
+    return readValue(nextLayer, index);
+}
+
+// Value of one position given the fully solved layer above it.
+int solvePosition(const Variant &variant, const Position &pos, const uint64_t *nextLayer) {
+    bool xToMove = sideToMove(pos) == 'X';
+    CellMask mine = xToMove ? pos.x : pos.o;
+    CellMask theirs = xToMove ? pos.o : pos.x;
+    if (hasLine(variant, theirs))
+        return hasLine(variant, mine) ? TB_INVALID : TB_LOSS;
+    if (hasLine(variant, mine))
+        return TB_INVALID;
+
+    CellMask empty = emptyCells(variant, pos);
+    if (!empty)
+        return TB_DRAW;
+
+    int best = TB_LOSS;
+    while (empty) {
+        CellMask bit = empty & (~empty + 1);
+        empty &= empty - 1;
+        Position child = pos;
+        if (xToMove)
+            child.x |= bit;
+        else
+            child.o |= bit;
+        int value = childValue(nextLayer, child);
+        if (value == TB_LOSS)
+            return TB_WIN;
+        if (value == TB_DRAW)
+            best = TB_DRAW;
+    }
+    return best;
+}
+
+// Solves the word range [firstWord, lastWord) of one layer.
+void solveRange(const Variant &variant, int layer, uint64_t entries, uint64_t *words,
+                const uint64_t *nextLayer, uint64_t firstWord, uint64_t lastWord) {
+    for (uint64_t w = firstWord; w < lastWord; ++w) {
+        uint64_t packed = 0;
+        for (uint64_t slot = 0; slot < 32; ++slot) {
+            uint64_t index = w * 32 + slot;
+            if (index >= entries)
+                break;
+            Position pos = positionAt(variant.cells, layer, index);
+            packed |= static_cast<uint64_t>(solvePosition(variant, pos, nextLayer)) << (slot * 2);
+        }
+        words[w] = packed;
+    }
+}
+
+} // namespace
+
+// ------------------------------------------------------------------
+// Solver
+
+bool solveTablebase(const Variant &variant, int threads, const std::string &path,
+                    TablebaseStats *stats, std::string *error) {
+    if (variant.cells == 0 || variant.cells > kTablebaseMaxCells) {
+        if (error)
+            *error = "board too large for a tablebase (at most " + std::to_string(kTablebaseMaxCells) + " cells)";
+        return false;
+    }
+    if (threads < 1)
+        threads = 1;
+
+    auto start = std::chrono::steady_clock::now();
+    const int layerCount = variant.cells + 1;
+    std::vector<std::vector<uint64_t>> layers(layerCount);
+    uint64_t positions = 0;
+
+    // Layers only depend on the layer with one more stone, so walk backwards
+    // from full boards; inside a layer every position is independent.
+    for (int layer = variant.cells; layer >= 0; --layer) {
+        uint64_t entries = layerEntries(variant.cells, layer);
+        uint64_t words = layerWords(entries);
+        layers[layer].assign(words, 0);
+        positions += entries;
+        const uint64_t *nextLayer = (layer < variant.cells) ? layers[layer + 1].data() : nullptr;
+
+        int workers = static_cast<int>(std::min<uint64_t>(threads, words));
+        std::vector<std::thread> pool;
+        uint64_t chunk = (words + workers - 1) / workers;
+        for (int t = 0; t < workers; ++t) {
+            uint64_t first = t * chunk;
+            uint64_t last = std::min(words, first + chunk);
+            if (first >= last)
+                break;
+            pool.emplace_back(solveRange, std::cref(variant), layer, entries, layers[layer].data(),
+                              nextLayer, first, last);
+        }
+        for (auto &worker : pool)
+            worker.join();
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        if (error)
+            *error = "cannot open " + path + " for writing";
+        return false;
+    }
+    TablebaseHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.size = static_cast<uint32_t>(variant.size);
+    header.k = static_cast<uint32_t>(variant.k);
+    header.layerCount = static_cast<uint32_t>(layerCount);
+    header.reserved = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t bytes = sizeof(header);
+    for (int layer = 0; layer < layerCount; ++layer) {
+        uint64_t entries = layerEntries(variant.cells, layer);
+        out.write(reinterpret_cast<const char*>(&entries), sizeof(entries));
+        bytes += sizeof(entries);
+    }
+    for (int layer = 0; layer < layerCount; ++layer) {
+        out.write(reinterpret_cast<const char*>(layers[layer].data()), layers[layer].size() * sizeof(uint64_t));
+        bytes += layers[layer].size() * sizeof(uint64_t);
+    }
+    out.close();
+    if (!out) {
+        if (error)
+            *error = "failed writing " + path;
+        return false;
+    }
+
+    if (stats) {
+        stats->positions = positions;
+        stats->bytes = bytes;
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats->rootValue = readValue(layers[0].data(), 0);
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------
+// Tablebase Implementation
+
+Tablebase::Tablebase()
+    : var(makeVariant(0, 0)), mapping(nullptr), mappingSize(0)
+{
+}
+
+Tablebase::~Tablebase()
+{
+    close();
+}
+
+bool Tablebase::open(const std::string &path)
+{
+    close();
+    const char *base = nullptr;
+    size_t fileSize = 0;
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            mapping = mapped;
+            mappingSize = static_cast<size_t>(info.st_size);
+            base = static_cast<const char*>(mapped);
+            fileSize = mappingSize;
+        }
+    }
+    ::close(fd);
+#endif
+    if (!base) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in)
+            return false;
+        fileSize = static_cast<size_t>(in.tellg());
+        buffer.assign((fileSize + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(fileSize));
+        if (!in) {
+            close();
+            return false;
+        }
+        base = reinterpret_cast<const char*>(buffer.data());
+    }
+
+    TablebaseHeader header;
+    if (fileSize < sizeof(header)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    Variant variant = makeVariant(static_cast<int>(header.size), static_cast<int>(header.k));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        variant.cells == 0 || variant.cells > kTablebaseMaxCells ||
+        header.layerCount != static_cast<uint32_t>(variant.cells + 1)) {
+        close();
+        return false;
+    }
+
+    size_t offset = sizeof(header) + header.layerCount * sizeof(uint64_t);
+    if (fileSize < offset) {
+        close();
+        return false;
+    }
+    const uint64_t *entries = reinterpret_cast<const uint64_t*>(base + sizeof(header));
+    for (uint32_t layer = 0; layer < header.layerCount; ++layer) {
+        if (entries[layer] != layerEntries(variant.cells, static_cast<int>(layer))) {
+            close();
+            return false;
+        }
+        layers.push_back(reinterpret_cast<const uint64_t*>(base + offset));
+        offset += layerWords(entries[layer]) * sizeof(uint64_t);
+    }
+    if (offset != fileSize) {
+        close();
+        return false;
+    }
+    var = variant;
+    return true;
+}
+
+void Tablebase::close()
+{
+#ifndef _WIN32
+    if (mapping)
+        munmap(const_cast<void*>(mapping), mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    buffer.clear();
+    layers.clear();
+    var = makeVariant(0, 0);
+}
+
+bool Tablebase::isOpen() const
+{
+    return !layers.empty();
+}
+
+const Variant &Tablebase::variant() const
+{
+    return var;
+}
+
+int Tablebase::probe(const Position &pos) const
+{
+    int layer;
+    uint64_t index;
+    if (!isOpen() || ((pos.x | pos.o) & ~var.full) || !positionIndex(pos, layer, index))
+        return TB_INVALID;
+    return readValue(layers[layer], index);
+}
+
+int Tablebase::bestMove(const Position &pos, int *value) const
+{
+    int current = probe(pos);
+    if (value)
+        *value = current;
+    if (current == TB_INVALID || hasLine(var, pos.x) || hasLine(var, pos.o))
+        return -1;
+
+    bool xToMove = sideToMove(pos) == 'X';
+    int bestCell = -1;
+    int bestRank = -1;
+    CellMask empty = emptyCells(var, pos);
+    while (empty) {
+        int cell = lowestCell(empty);
+        empty &= empty - 1;
+        Position child = pos;
+        if (xToMove)
+            child.x |= cellBit(cell);
+        else
+            child.o |= cellBit(cell);
+        // The child's value is the opponent's, so their loss is our best result.
+        int childResult = probe(child);
+        int rank = (childResult == TB_LOSS) ? 3 : (childResult == TB_DRAW) ? 2 : (childResult == TB_WIN) ? 1 : 0;
+        if (rank > bestRank) {
+            bestRank = rank;
+            bestCell = cell;
+        }
+    }
+    return bestCell;
+}
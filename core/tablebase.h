@@ -0,0 +1,68 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+// Perfect-play tablebase for small k-in-a-row variants (up to 16 cells).
+// Every position reachable by alternating play is stored with 2 bits, in
+// layers by stone count. Within a layer a position's index is the
+// combinatorial rank of its occupied cells times the rank of which of those
+// cells hold X, so there are no gaps and no hashing.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bitboard.h"
+
+// Values are from the point of view of the side to move.
+enum TablebaseValue {
+    TB_INVALID = 0, // both sides have lines, or the side to move already won
+    TB_LOSS = 1,
+    TB_DRAW = 2,
+    TB_WIN = 3
+};
+
+// --- TablebaseStats Struct Definition ---
+// Filled by solveTablebase for throughput reporting.
+struct TablebaseStats {
+    uint64_t positions;
+    uint64_t bytes;
+    double seconds;
+    int rootValue;
+};
+
+// Largest board the solver accepts. 5x5 would need ~10^11 entries.
+const int kTablebaseMaxCells = 16;
+
+// Solves the variant layer by layer, from full boards back to the empty
+// board, splitting each layer across threads, and writes it to path.
+bool solveTablebase(const Variant &variant, int threads, const std::string &path,
+                    TablebaseStats *stats, std::string *error);
+
+// --- Tablebase Class Definition ---
+// Read-only view of a tablebase file, memory-mapped where supported.
+class Tablebase
+{
+public:
+    Tablebase();
+    ~Tablebase();
+    Tablebase(const Tablebase &) = delete;
+    Tablebase &operator=(const Tablebase &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+    const Variant &variant() const;
+
+    int probe(const Position &pos) const;
+    // Returns the cell of a best move for the side to move, or -1.
+    int bestMove(const Position &pos, int *value = nullptr) const;
+
+private:
+    Variant var;
+    std::vector<const uint64_t*> layers;
+    const void *mapping;
+    size_t mappingSize;
+    std::vector<uint64_t> buffer; // used when the file cannot be mapped
+};
+
+#endif // TABLEBASE_H
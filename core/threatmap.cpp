@@ -0,0 +1,157 @@
+#include "threatmap.h"
+
+#include <algorithm>
+
+// ------------------------------------------------------------------
+// Helper functions
+
+namespace {
+
+const int kCompleteBonus = 1 << 24;
+const int kBlockBonus = 1 << 20;
+
+int sideIndex(char player) {
+    return player == 'X' ? 0 : 1;
+}
+
+// Grows 8x per stone already in the window, capped to stay within int.
+int stoneWeight(int stones) {
+    return 1 << (3 * std::min(stones, 6));
+}
+
+} // namespace
+
+// ------------------------------------------------------------------
+// ThreatMap Implementation
+
+ThreatMap::ThreatMap(int size, int k)
+{
+    reset(size, k);
+}
+
+void ThreatMap::reset(int size, int k)
+{
+    boardSize = std::min(std::max(size, 1), kThreatMapMaxSize);
+    lineLength = std::min(std::max(k, 1), boardSize);
+    const int cells = boardSize * boardSize;
+
+    windows.clear();
+    std::vector<std::vector<int>> through(cells);
+    const int dirs[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+    for (int row = 0; row < boardSize; ++row) {
+        for (int col = 0; col < boardSize; ++col) {
+            for (const auto &dir : dirs) {
+                const int endRow = row + dir[0] * (lineLength - 1);
+                const int endCol = col + dir[1] * (lineLength - 1);
+                if (endRow < 0 || endRow >= boardSize || endCol < 0 || endCol >= boardSize)
+                    continue;
+                Window window = { row * boardSize + col, dir[0] * boardSize + dir[1], { 0, 0 } };
+                for (int i = 0; i < lineLength; ++i)
+                    through[window.first + i * window.step].push_back(static_cast<int>(windows.size()));
+                windows.push_back(window);
+            }
+        }
+    }
+    cellWindowStart.assign(cells + 1, 0);
+    cellWindows.clear();
+    for (int cell = 0; cell < cells; ++cell) {
+        cellWindowStart[cell] = static_cast<int>(cellWindows.size());
+        cellWindows.insert(cellWindows.end(), through[cell].begin(), through[cell].end());
+    }
+    cellWindowStart[cells] = static_cast<int>(cellWindows.size());
+    clear();
+}
+
+void ThreatMap::clear()
+{
+    const int cells = boardSize * boardSize;
+    stones.assign(cells, ' ');
+    scores[0].assign(cells, 0);
+    scores[1].assign(cells, 0);
+    for (Window &window : windows) {
+        window.count[0] = window.count[1] = 0;
+        addWindow(window, 1);
+    }
+}
+
+int ThreatMap::size() const
+{
+    return boardSize;
+}
+
+int ThreatMap::k() const
+{
+    return lineLength;
+}
+
+int ThreatMap::windowValue(const Window &window, int side) const
+{
+    const int own = window.count[side];
+    const int other = window.count[1 - side];
+    if (own > 0 && other > 0)
+        return 0; // dead for both sides
+    if (other == 0)
+        return stoneWeight(own) + (own == lineLength - 1 ? kCompleteBonus : 0);
+    return stoneWeight(other) + (other == lineLength - 1 ? kBlockBonus : 0);
+}
+
+void ThreatMap::addWindow(const Window &window, int sign)
+{
+    const int valueX = sign * windowValue(window, 0);
+    const int valueO = sign * windowValue(window, 1);
+    for (int i = 0; i < lineLength; ++i) {
+        const int cell = window.first + i * window.step;
+        scores[0][cell] += valueX;
+        scores[1][cell] += valueO;
+    }
+}
+
+void ThreatMap::setStone(int cell, char player)
+{
+    const char previous = stones[cell];
+    if (previous == player)
+        return;
+    for (int i = cellWindowStart[cell]; i < cellWindowStart[cell + 1]; ++i) {
+        Window &window = windows[cellWindows[i]];
+        addWindow(window, -1);
+        if (previous != ' ')
+            window.count[sideIndex(previous)]--;
+        if (player != ' ')
+            window.count[sideIndex(player)]++;
+        addWindow(window, 1);
+    }
+    stones[cell] = player;
+}
+
+void ThreatMap::play(int cell, char player)
+{
+    if (cell >= 0 && cell < static_cast<int>(stones.size()) && (player == 'X' || player == 'O'))
+        setStone(cell, player);
+}
+
+void ThreatMap::undo(int cell)
+{
+    if (cell >= 0 && cell < static_cast<int>(stones.size()))
+        setStone(cell, ' ');
+}
+
+char ThreatMap::stoneAt(int cell) const
+{
+    return stones[cell];
+}
+
+int ThreatMap::cellScore(int cell, char player) const
+{
+    return scores[sideIndex(player)][cell];
+}
+
+bool ThreatMap::completesLine(int cell, char player) const
+{
+    const int side = sideIndex(player);
+    for (int i = cellWindowStart[cell]; i < cellWindowStart[cell + 1]; ++i) {
+        const Window &window = windows[cellWindows[i]];
+        if (window.count[side] == lineLength - 1 && window.count[1 - side] == 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,60 @@
+#ifndef THREATMAP_H
+#define THREATMAP_H
+
+// Incremental line-threat bookkeeping for k-in-a-row boards up to 19x19.
+// Every window of k cells keeps its X and O stone counts, and every cell
+// keeps, for each side, the sum of what the windows through it are worth
+// to that side. A move only touches the windows through its own cell (at
+// most 4k of them), so per-cell scores stay current in O(k^2) per move
+// instead of a full rescan of the board.
+
+#include <vector>
+
+const int kThreatMapMaxSize = 19;
+
+// --- ThreatMap Class Definition ---
+class ThreatMap
+{
+public:
+    ThreatMap(int size = 3, int k = 3);
+
+    // Sets the geometry and empties the board. Size is clamped to
+    // 1..kThreatMapMaxSize and k to 1..size.
+    void reset(int size, int k);
+    // Empties the board, keeping the geometry.
+    void clear();
+    int size() const;
+    int k() const;
+
+    void play(int cell, char player);
+    void undo(int cell);
+    char stoneAt(int cell) const;
+
+    // What playing the (empty) cell is worth to player: windows it extends
+    // for player plus windows of the opponent it blocks. Completing a line
+    // outranks blocking one, which outranks everything else.
+    int cellScore(int cell, char player) const;
+    // True if player completes a line by playing cell.
+    bool completesLine(int cell, char player) const;
+
+private:
+    struct Window {
+        int first;
+        int step;
+        int count[2]; // stones of X, O
+    };
+
+    int windowValue(const Window &window, int side) const;
+    void addWindow(const Window &window, int sign);
+    void setStone(int cell, char player);
+
+    int boardSize;
+    int lineLength;
+    std::vector<Window> windows;
+    std::vector<int> cellWindowStart; // windows through cell c: cellWindows[start[c] .. start[c + 1])
+    std::vector<int> cellWindows;
+    std::vector<char> stones;
+    std::vector<int> scores[2];
+};
+
+#endif // THREATMAP_H
@@ -0,0 +1,102 @@
+#ifndef TICTACTOE_H
+#define TICTACTOE_H
+
+/*
+ * Stable C API of the game core, for embedding it in services or binding
+ * it from other languages. The C++ headers next to this one are the
+ * internal API used by the app and the tools and may change at any time;
+ * this one only grows, and TTT_API_VERSION goes up when it does.
+ *
+ * A ttt_game is a k-in-a-row game on a size x size board (up to 8x8).
+ * Functions never throw; failures are negative TTT_ERROR_* codes or NULL.
+ * A game object may be used from one thread at a time; separate games are
+ * independent.
+ */
+
+#include <stddef.h>
+
+#define TTT_API_VERSION 2
+
+#if defined(_WIN32) && defined(TTT_BUILD_SHARED)
+#define TTT_API __declspec(dllexport)
+#elif defined(_WIN32) && defined(TTT_USE_SHARED)
+#define TTT_API __declspec(dllimport)
+#elif defined(__GNUC__) || defined(__clang__)
+#define TTT_API __attribute__((visibility("default")))
+#else
+#define TTT_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ttt_game ttt_game;
+
+enum {
+    TTT_ONGOING = 0,
+    TTT_X_WINS = 1,
+    TTT_O_WINS = 2,
+    TTT_DRAW = 3
+};
+
+enum {
+    TTT_OK = 0,
+    TTT_ERROR_ARGUMENT = -1, /* NULL pointer or coordinates off the board */
+    TTT_ERROR_ILLEGAL = -2,  /* occupied cell, game over or nothing to undo */
+    TTT_ERROR_MEMORY = -3,
+    TTT_ERROR_FORMAT = -4    /* history line or tablebase that cannot be read */
+};
+
+/* TTT_API_VERSION of the library actually linked. */
+TTT_API int ttt_api_version(void);
+
+/* New empty game; NULL for an unsupported size/k or when out of memory. */
+TTT_API ttt_game *ttt_game_new(int size, int k);
+TTT_API void ttt_game_free(ttt_game *game);
+TTT_API void ttt_game_reset(ttt_game *game);
+
+TTT_API int ttt_game_size(const ttt_game *game);
+TTT_API int ttt_game_move_count(const ttt_game *game);
+/* 'X', 'O' or ' ' (also for coordinates off the board). */
+TTT_API char ttt_game_cell(const ttt_game *game, int row, int col);
+/* 'X' or 'O'. */
+TTT_API char ttt_game_to_move(const ttt_game *game);
+/* One of TTT_ONGOING, TTT_X_WINS, TTT_O_WINS, TTT_DRAW. */
+TTT_API int ttt_game_result(const ttt_game *game);
+
+/* Plays for the side to move. */
+TTT_API int ttt_game_play(ttt_game *game, int row, int col);
+TTT_API int ttt_game_undo(ttt_game *game);
+
+/*
+ * Searches a move for the side to move: alpha-beta with iterative deepening
+ * up to depth plies (0 = to the end of the game, which is exact) and at most
+ * time_ms milliseconds after the first ply (0 = no limit). score (may be
+ * NULL) is from the mover's view; a win is at least 1000000 - cells.
+ */
+TTT_API int ttt_game_best_move(const ttt_game *game, int depth, int time_ms, int *row, int *col, int *score);
+
+/*
+ * Since version 2. Attaches a tablebase written by tictactoe-solver for the
+ * game's size and k; ttt_game_best_move then answers from it instantly with
+ * perfect play. NULL detaches it. TTT_ERROR_FORMAT if the file cannot be
+ * opened or is for another variant.
+ */
+TTT_API int ttt_game_use_tablebase(ttt_game *game, const char *path);
+
+/*
+ * History lines in the app's format, "mode|winner|row-col-player;...".
+ * Loading replaces the game with the line's moves; on error the game is
+ * unchanged. Saving works like snprintf: it returns the full length of the
+ * line and writes at most size - 1 characters plus a terminating NUL.
+ * A NULL winner is filled in from the result ("X", "O", "Draw" or "").
+ */
+TTT_API int ttt_game_load_record(ttt_game *game, const char *line);
+TTT_API int ttt_game_save_record(const ttt_game *game, const char *mode, const char *winner, char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TICTACTOE_H */
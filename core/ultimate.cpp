@@ -0,0 +1,284 @@
+#include "ultimate.h"
+#include "bitboard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+// ------------------------------------------------------------------
+// Helper functions
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const uint16_t kFull = 0x1FF;
+const uint16_t kLines[8] = { 0x007, 0x038, 0x1C0, 0x049, 0x092, 0x124, 0x111, 0x054 };
+// Centre sub-board and corners take part in more meta lines.
+const int kBoardWeight[9] = { 3, 2, 3, 2, 4, 2, 3, 2, 3 };
+
+// Per 9-bit mask: whether it holds a line, which of the 8 lines it has
+// exactly two stones on, and which lines it touches at all.
+struct LineTables {
+    bool win[512];
+    uint8_t twos[512];
+    uint8_t touched[512];
+    LineTables() {
+        for (int mask = 0; mask < 512; ++mask) {
+            win[mask] = false;
+            twos[mask] = 0;
+            touched[mask] = 0;
+            for (int line = 0; line < 8; ++line) {
+                const int stones = popCount(static_cast<CellMask>(mask & kLines[line]));
+                if (stones == 3)
+                    win[mask] = true;
+                if (stones == 2)
+                    twos[mask] |= 1 << line;
+                if (stones > 0)
+                    touched[mask] |= 1 << line;
+            }
+        }
+    }
+};
+
+const LineTables &tables() {
+    static const LineTables instance;
+    return instance;
+}
+
+int bitCount(unsigned value) {
+    return popCount(static_cast<CellMask>(value));
+}
+
+// Lines where `own` has two and `other` has nothing.
+int openTwos(uint16_t own, uint16_t other) {
+    const LineTables &t = tables();
+    return bitCount(t.twos[own] & ~t.touched[other]);
+}
+
+int evaluate(const UltimatePosition &pos) {
+    const bool xToMove = pos.toMove == 'X';
+    const uint16_t ownMeta = xToMove ? pos.metaX : pos.metaO;
+    const uint16_t otherMeta = xToMove ? pos.metaO : pos.metaX;
+    const uint16_t drawn = pos.metaClosed & ~(pos.metaX | pos.metaO);
+
+    int score = 0;
+    for (int board = 0; board < 9; ++board) {
+        if (ownMeta & (1 << board))
+            score += 40 * kBoardWeight[board];
+        else if (otherMeta & (1 << board))
+            score -= 40 * kBoardWeight[board];
+        if (pos.metaClosed & (1 << board))
+            continue;
+        const uint16_t own = xToMove ? pos.x[board] : pos.o[board];
+        const uint16_t other = xToMove ? pos.o[board] : pos.x[board];
+        int local = 8 * (openTwos(own, other) - openTwos(other, own));
+        local += 2 * (((own >> 4) & 1) - ((other >> 4) & 1));
+        score += local * kBoardWeight[board];
+    }
+    // A drawn sub-board blocks meta lines for both sides.
+    score += 300 * (openTwos(ownMeta, otherMeta | drawn) - openTwos(otherMeta, ownMeta | drawn));
+    return score;
+}
+
+struct SearchContext {
+    Clock::time_point deadline;
+    bool timed;
+    bool aborted;
+    uint64_t nodes;
+};
+
+bool outOfTime(SearchContext &ctx) {
+    if (ctx.timed && (ctx.nodes & 1023) == 0 && Clock::now() >= ctx.deadline)
+        ctx.aborted = true;
+    return ctx.aborted;
+}
+
+// Moves that win a sub-board first, then ones that stop the opponent
+// winning one, then the rest in generation order.
+void orderMoves(const UltimatePosition &pos, uint8_t *moves, int count) {
+    const bool xToMove = pos.toMove == 'X';
+    int keys[81];
+    for (int i = 0; i < count; ++i) {
+        const int board = moves[i] / 9;
+        const uint16_t bit = 1 << (moves[i] % 9);
+        const uint16_t own = xToMove ? pos.x[board] : pos.o[board];
+        const uint16_t other = xToMove ? pos.o[board] : pos.x[board];
+        keys[i] = ultimateHasLine(own | bit) ? 2 : (ultimateHasLine(other | bit) ? 1 : 0);
+    }
+    // Insertion sort: at most 81 moves, usually 9 or fewer.
+    for (int i = 1; i < count; ++i) {
+        const uint8_t move = moves[i];
+        const int key = keys[i];
+        int j = i - 1;
+        for (; j >= 0 && keys[j] < key; --j) {
+            moves[j + 1] = moves[j];
+            keys[j + 1] = keys[j];
+        }
+        moves[j + 1] = move;
+        keys[j + 1] = key;
+    }
+}
+
+int negamax(SearchContext &ctx, const UltimatePosition &pos, int depth, int ply, int alpha, int beta) {
+    ctx.nodes++;
+    // Only the side that just moved can have completed a meta line.
+    if (ultimateHasLine(pos.toMove == 'X' ? pos.metaO : pos.metaX))
+        return -(kUltimateWinScore - ply);
+    uint8_t moves[81];
+    const int count = ultimateMoves(pos, moves);
+    if (count == 0)
+        return 0;
+    if (depth == 0)
+        return evaluate(pos);
+    if (outOfTime(ctx))
+        return 0;
+
+    orderMoves(pos, moves, count);
+    int best = -kUltimateWinScore - 1;
+    for (int i = 0; i < count; ++i) {
+        UltimatePosition next = pos;
+        ultimatePlay(next, moves[i]);
+        const int score = -negamax(ctx, next, depth - 1, ply + 1, -beta, -alpha);
+        if (ctx.aborted)
+            return 0;
+        best = std::max(best, score);
+        alpha = std::max(alpha, score);
+        if (alpha >= beta)
+            break;
+    }
+    return best;
+}
+
+} // namespace
+
+void ultimateReset(UltimatePosition &pos) {
+    for (int board = 0; board < 9; ++board) {
+        pos.x[board] = 0;
+        pos.o[board] = 0;
+    }
+    pos.metaX = 0;
+    pos.metaO = 0;
+    pos.metaClosed = 0;
+    pos.forced = -1;
+    pos.toMove = 'X';
+}
+
+bool ultimateHasLine(uint16_t mask) {
+    return tables().win[mask & kFull];
+}
+
+int ultimateMoves(const UltimatePosition &pos, uint8_t *moves) {
+    if (ultimateHasLine(pos.metaX) || ultimateHasLine(pos.metaO))
+        return 0;
+    int count = 0;
+    const int first = pos.forced >= 0 ? pos.forced : 0;
+    const int last = pos.forced >= 0 ? pos.forced : 8;
+    for (int board = first; board <= last; ++board) {
+        if (pos.metaClosed & (1 << board))
+            continue;
+        const uint16_t empty = kFull & ~(pos.x[board] | pos.o[board]);
+        for (int cell = 0; cell < 9; ++cell)
+            if (empty & (1 << cell))
+                moves[count++] = static_cast<uint8_t>(board * 9 + cell);
+    }
+    return count;
+}
+
+bool ultimateIsLegal(const UltimatePosition &pos, int move) {
+    if (move < 0 || move >= 81 || ultimateWinner(pos) != ' ')
+        return false;
+    const int board = move / 9;
+    if ((pos.forced >= 0 && board != pos.forced) || (pos.metaClosed & (1 << board)))
+        return false;
+    return !((pos.x[board] | pos.o[board]) & (1 << (move % 9)));
+}
+
+void ultimatePlay(UltimatePosition &pos, int move) {
+    const int board = move / 9;
+    const int cell = move % 9;
+    const bool xMoves = pos.toMove == 'X';
+    uint16_t &own = xMoves ? pos.x[board] : pos.o[board];
+    own |= 1 << cell;
+    if (ultimateHasLine(own)) {
+        (xMoves ? pos.metaX : pos.metaO) |= 1 << board;
+        pos.metaClosed |= 1 << board;
+    } else if ((pos.x[board] | pos.o[board]) == kFull) {
+        pos.metaClosed |= 1 << board;
+    }
+    pos.forced = (pos.metaClosed & (1 << cell)) ? -1 : static_cast<int8_t>(cell);
+    pos.toMove = xMoves ? 'O' : 'X';
+}
+
+char ultimateWinner(const UltimatePosition &pos) {
+    if (ultimateHasLine(pos.metaX))
+        return 'X';
+    if (ultimateHasLine(pos.metaO))
+        return 'O';
+    return pos.metaClosed == kFull ? 'D' : ' ';
+}
+
+int ultimateMoveAt(int row, int col) {
+    if (row < 0 || row >= 9 || col < 0 || col >= 9)
+        return -1;
+    return ((row / 3) * 3 + col / 3) * 9 + (row % 3) * 3 + col % 3;
+}
+
+int ultimateRow(int move) {
+    return (move / 9) / 3 * 3 + (move % 9) / 3;
+}
+
+int ultimateCol(int move) {
+    return (move / 9) % 3 * 3 + (move % 9) % 3;
+}
+
+UltimateSearchResult ultimateSearch(const UltimatePosition &pos, int timeMs, int maxDepth) {
+    UltimateSearchResult result = { -1, 0, 0, 0 };
+    uint8_t moves[81];
+    const int count = ultimateMoves(pos, moves);
+    if (count == 0)
+        return result;
+    orderMoves(pos, moves, count);
+
+    // No line can take more plies than there are empty cells in open sub-boards.
+    int empty = 0;
+    for (int board = 0; board < 9; ++board)
+        if (!(pos.metaClosed & (1 << board)))
+            empty += 9 - bitCount(pos.x[board] | pos.o[board]);
+
+    SearchContext ctx;
+    ctx.timed = false;
+    ctx.aborted = false;
+    ctx.nodes = 0;
+    for (int depth = 1; depth <= std::min(std::max(maxDepth, 1), empty); ++depth) {
+        // Depth 1 always finishes so there is a move to play.
+        if (depth == 2 && timeMs > 0) {
+            ctx.timed = true;
+            ctx.deadline = Clock::now() + std::chrono::milliseconds(timeMs);
+        }
+        int bestIndex = -1;
+        int alpha = -kUltimateWinScore - 1;
+        const int beta = kUltimateWinScore + 1;
+        for (int i = 0; i < count && !ctx.aborted; ++i) {
+            UltimatePosition next = pos;
+            ultimatePlay(next, moves[i]);
+            // Moves after the best so far only need to prove they are worse.
+            const int score = -negamax(ctx, next, depth - 1, 1, -beta, -alpha);
+            if (!ctx.aborted && score > alpha) {
+                alpha = score;
+                bestIndex = i;
+            }
+        }
+        if (ctx.aborted || bestIndex < 0)
+            break;
+        result.move = moves[bestIndex];
+        result.score = alpha;
+        result.depth = depth;
+        // Next iteration starts from this one's best move.
+        std::rotate(moves, moves + bestIndex, moves + bestIndex + 1);
+        if (std::abs(alpha) >= kUltimateWinScore - 81)
+            break;
+    }
+    result.nodes = ctx.nodes;
+    return result;
+}
@@ -0,0 +1,58 @@
+#ifndef ULTIMATE_H
+#define ULTIMATE_H
+
+// Ultimate tic-tac-toe: nine 3x3 sub-boards whose results form a 3x3
+// meta-board. A move in cell c sends the opponent to sub-board c; if that
+// sub-board is already won or full they may play in any open one. Three
+// won sub-boards in a row win the game; when every sub-board is closed
+// without that, it is a draw.
+//
+// Each sub-board is a 9-bit mask per side (bit = row * 3 + col), as is the
+// meta-board, so line checks are lookups in one 512-entry table. Moves are
+// numbered board * 9 + cell.
+
+#include <cstdint>
+
+// --- UltimatePosition Struct Definition ---
+struct UltimatePosition {
+    uint16_t x[9];
+    uint16_t o[9];
+    uint16_t metaX;      // sub-boards won by X
+    uint16_t metaO;      // sub-boards won by O
+    uint16_t metaClosed; // sub-boards won or full
+    int8_t forced;       // sub-board the next move must be in, -1 = any open one
+    char toMove;
+};
+
+// --- UltimateSearchResult Struct Definition ---
+struct UltimateSearchResult {
+    int move;       // -1 when the game is over
+    int score;      // side to move's view; |score| >= kUltimateWinScore - 81 is a forced result
+    int depth;      // deepest iteration that finished
+    uint64_t nodes;
+};
+
+const int kUltimateWinScore = 1000000;
+
+void ultimateReset(UltimatePosition &pos);
+// True if the 9-bit mask of one side holds a line (table lookup).
+bool ultimateHasLine(uint16_t mask);
+// Fills moves (room for 81) and returns how many there are; 0 once the game is over.
+int ultimateMoves(const UltimatePosition &pos, uint8_t *moves);
+bool ultimateIsLegal(const UltimatePosition &pos, int move);
+// Plays a legal move for pos.toMove.
+void ultimatePlay(UltimatePosition &pos, int move);
+// 'X' or 'O' for a meta-board line, 'D' for a draw, ' ' while undecided.
+char ultimateWinner(const UltimatePosition &pos);
+
+// Converts between move numbers and the 9x9 row/column of history records.
+int ultimateMoveAt(int row, int col);
+int ultimateRow(int move);
+int ultimateCol(int move);
+
+// Iterative-deepening alpha-beta. Depth 1 always finishes; after that the
+// search stops once timeMs has passed and plays the last finished depth.
+// timeMs = 0 means no limit, so keep maxDepth small then.
+UltimateSearchResult ultimateSearch(const UltimatePosition &pos, int timeMs, int maxDepth = 64);
+
+#endif // ULTIMATE_H
@@ -0,0 +1,201 @@
+#include "winbatch.h"
+
+#include <atomic>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define WINBATCH_X86 1
+#include <immintrin.h>
+#endif
+
+// ------------------------------------------------------------------
+// Scalar kernels (reference behaviour for the SIMD versions)
+
+static void hasLineScalar(const Variant &variant, const CellMask *stones, size_t first, size_t count, uint8_t *result) {
+    for (size_t i = first; i < count; ++i)
+        result[i] = hasLine(variant, stones[i]) ? 1 : 0;
+}
+
+static void openLinesScalar(const Variant &variant, const CellMask *theirs, size_t first, size_t count, int32_t *result) {
+    for (size_t i = first; i < count; ++i) {
+        int32_t open = 0;
+        for (CellMask line : variant.lines)
+            if ((theirs[i] & line) == 0)
+                ++open;
+        result[i] = open;
+    }
+}
+
+#ifdef WINBATCH_X86
+
+// ------------------------------------------------------------------
+// AVX2 kernels: 4 boards per register, two registers per iteration
+
+__attribute__((target("avx2")))
+static void hasLineAvx2(const Variant &variant, const CellMask *stones, size_t count, uint8_t *result) {
+    const CellMask *lines = variant.lines.data();
+    const size_t lineCount = variant.lines.size();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stones + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stones + i + 4));
+        __m256i hitA = _mm256_setzero_si256();
+        __m256i hitB = _mm256_setzero_si256();
+        for (size_t l = 0; l < lineCount; ++l) {
+            __m256i mask = _mm256_set1_epi64x(static_cast<long long>(lines[l]));
+            hitA = _mm256_or_si256(hitA, _mm256_cmpeq_epi64(_mm256_and_si256(a, mask), mask));
+            hitB = _mm256_or_si256(hitB, _mm256_cmpeq_epi64(_mm256_and_si256(b, mask), mask));
+        }
+        int bits = _mm256_movemask_pd(_mm256_castsi256_pd(hitA)) |
+                   (_mm256_movemask_pd(_mm256_castsi256_pd(hitB)) << 4);
+        for (int j = 0; j < 8; ++j)
+            result[i + j] = static_cast<uint8_t>((bits >> j) & 1);
+    }
+    hasLineScalar(variant, stones, i, count, result);
+}
+
+__attribute__((target("avx2")))
+static void openLinesAvx2(const Variant &variant, const CellMask *theirs, size_t count, int32_t *result) {
+    const CellMask *lines = variant.lines.data();
+    const size_t lineCount = variant.lines.size();
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(theirs + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(theirs + i + 4));
+        __m256i openA = zero;
+        __m256i openB = zero;
+        for (size_t l = 0; l < lineCount; ++l) {
+            __m256i mask = _mm256_set1_epi64x(static_cast<long long>(lines[l]));
+            // A true compare is all ones (-1), so subtracting it counts the line.
+            openA = _mm256_sub_epi64(openA, _mm256_cmpeq_epi64(_mm256_and_si256(a, mask), zero));
+            openB = _mm256_sub_epi64(openB, _mm256_cmpeq_epi64(_mm256_and_si256(b, mask), zero));
+        }
+        alignas(32) int64_t counts[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(counts), openA);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(counts + 4), openB);
+        for (int j = 0; j < 8; ++j)
+            result[i + j] = static_cast<int32_t>(counts[j]);
+    }
+    openLinesScalar(variant, theirs, i, count, result);
+}
+
+// ------------------------------------------------------------------
+// SSE4.1 kernels: 2 boards per register, two registers per iteration
+
+__attribute__((target("sse4.1")))
+static void hasLineSse41(const Variant &variant, const CellMask *stones, size_t count, uint8_t *result) {
+    const CellMask *lines = variant.lines.data();
+    const size_t lineCount = variant.lines.size();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stones + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stones + i + 2));
+        __m128i hitA = _mm_setzero_si128();
+        __m128i hitB = _mm_setzero_si128();
+        for (size_t l = 0; l < lineCount; ++l) {
+            __m128i mask = _mm_set1_epi64x(static_cast<long long>(lines[l]));
+            hitA = _mm_or_si128(hitA, _mm_cmpeq_epi64(_mm_and_si128(a, mask), mask));
+            hitB = _mm_or_si128(hitB, _mm_cmpeq_epi64(_mm_and_si128(b, mask), mask));
+        }
+        int bits = _mm_movemask_pd(_mm_castsi128_pd(hitA)) | (_mm_movemask_pd(_mm_castsi128_pd(hitB)) << 2);
+        for (int j = 0; j < 4; ++j)
+            result[i + j] = static_cast<uint8_t>((bits >> j) & 1);
+    }
+    hasLineScalar(variant, stones, i, count, result);
+}
+
+__attribute__((target("sse4.1")))
+static void openLinesSse41(const Variant &variant, const CellMask *theirs, size_t count, int32_t *result) {
+    const CellMask *lines = variant.lines.data();
+    const size_t lineCount = variant.lines.size();
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(theirs + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(theirs + i + 2));
+        __m128i openA = zero;
+        __m128i openB = zero;
+        for (size_t l = 0; l < lineCount; ++l) {
+            __m128i mask = _mm_set1_epi64x(static_cast<long long>(lines[l]));
+            openA = _mm_sub_epi64(openA, _mm_cmpeq_epi64(_mm_and_si128(a, mask), zero));
+            openB = _mm_sub_epi64(openB, _mm_cmpeq_epi64(_mm_and_si128(b, mask), zero));
+        }
+        alignas(16) int64_t counts[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(counts), openA);
+        _mm_store_si128(reinterpret_cast<__m128i*>(counts + 2), openB);
+        for (int j = 0; j < 4; ++j)
+            result[i + j] = static_cast<int32_t>(counts[j]);
+    }
+    openLinesScalar(variant, theirs, i, count, result);
+}
+
+#endif // WINBATCH_X86
+
+// ------------------------------------------------------------------
+// Dispatch
+
+static BatchKernel bestSupportedKernel() {
+#ifdef WINBATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return BATCH_AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return BATCH_SSE41;
+#endif
+    return BATCH_SCALAR;
+}
+
+static std::atomic<int> &currentKernel() {
+    static std::atomic<int> kernel(bestSupportedKernel());
+    return kernel;
+}
+
+void setBatchKernel(BatchKernel kernel) {
+    BatchKernel best = bestSupportedKernel();
+    if (kernel == BATCH_AUTO || kernel > best)
+        kernel = best;
+    currentKernel().store(kernel);
+}
+
+BatchKernel activeBatchKernel() {
+    return static_cast<BatchKernel>(currentKernel().load());
+}
+
+const char *batchKernelName(BatchKernel kernel) {
+    switch (kernel) {
+    case BATCH_AVX2: return "avx2";
+    case BATCH_SSE41: return "sse4.1";
+    case BATCH_SCALAR: return "scalar";
+    default: return "auto";
+    }
+}
+
+void batchHasLine(const Variant &variant, const CellMask *stones, size_t count, uint8_t *result) {
+    switch (activeBatchKernel()) {
+#ifdef WINBATCH_X86
+    case BATCH_AVX2:
+        hasLineAvx2(variant, stones, count, result);
+        return;
+    case BATCH_SSE41:
+        hasLineSse41(variant, stones, count, result);
+        return;
+#endif
+    default:
+        hasLineScalar(variant, stones, 0, count, result);
+    }
+}
+
+void batchOpenLines(const Variant &variant, const CellMask *theirs, size_t count, int32_t *result) {
+    switch (activeBatchKernel()) {
+#ifdef WINBATCH_X86
+    case BATCH_AVX2:
+        openLinesAvx2(variant, theirs, count, result);
+        return;
+    case BATCH_SSE41:
+        openLinesSse41(variant, theirs, count, result);
+        return;
+#endif
+    default:
+        openLinesScalar(variant, theirs, 0, count, result);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef WINBATCH_H
+#define WINBATCH_H
+
+// Batched terminal checks and line counting over many boards at once. Each
+// board is a stone mask for one side (see bitboard.h). The kernel is picked
+// at run time: AVX2, then SSE4.1, then plain scalar code.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bitboard.h"
+
+enum BatchKernel {
+    BATCH_AUTO,
+    BATCH_SCALAR,
+    BATCH_SSE41,
+    BATCH_AVX2
+};
+
+// Forces a kernel (BATCH_AUTO restores the best supported one). Requests for
+// kernels the CPU lacks fall back to the best supported one.
+void setBatchKernel(BatchKernel kernel);
+BatchKernel activeBatchKernel();
+const char *batchKernelName(BatchKernel kernel);
+
+// result[i] = 1 if stones[i] completes any line of the variant, else 0.
+void batchHasLine(const Variant &variant, const CellMask *stones, size_t count, uint8_t *result);
+
+// result[i] = number of lines that contain no stone of theirs[i], i.e. lines
+// the other side can still complete.
+void batchOpenLines(const Variant &variant, const CellMask *theirs, size_t count, int32_t *result);
+
+#endif // WINBATCH_H
@@ -5,6 +5,10 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    MainWindow::useTrieHistory = a.arguments().contains("--trie-history");
+    const int cacheArgument = a.arguments().indexOf("--history-cache-mb");
+    if (cacheArgument > 0 && cacheArgument + 1 < a.arguments().size())
+        MainWindow::historyCache.setCapacity(a.arguments()[cacheArgument + 1].toULongLong() * 1024 * 1024);
     MainWindow w;
     w.show();
     return a.exec();
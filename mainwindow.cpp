@@ -1,8 +1,11 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "bitboard.h"
 
 #include <QMessageBox>
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QTextStream>
 #include <QInputDialog>
 #include <QStackedWidget>
@@ -11,37 +14,32 @@
 #include <QTextEdit>
 #include <QScrollBar>
 #include <QComboBox>
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <unordered_set>
+#include <cmath>
 
 // ------------------------------------------------------------------
-// Helper functions for minimax evaluation (operate on a given board state)
+// GameBoard Implementation
 
-static bool evalIsWinner(const std::vector<std::vector<char>> &board, char player) {
-    for (int i = 0; i < 3; i++) {
-        if (board[i][0] == player && board[i][1] == player && board[i][2] == player)
-            return true;
-        if (board[0][i] == player && board[1][i] == player && board[2][i] == player)
-            return true;
-    }
-    if (board[0][0] == player && board[1][1] == player && board[2][2] == player)
-        return true;
-    if (board[0][2] == player && board[1][1] == player && board[2][0] == player)
-        return true;
-    return false;
-}
+// A 3x3 game is proven in a few hundred nodes; the budget only matters
+// if the board ever grows.
+static const uint64_t kAiProofNodes = 100000;
+static const size_t kAiProofTableBytes = 1 << 20;
 
-static bool evalIsFull(const std::vector<std::vector<char>> &board) {
+static std::string boardKey(const BoardState &board)
+{
+    std::string key;
     for (const auto &row : board)
-        for (char cell : row)
-            if (cell == ' ')
-                return false;
-    return true;
+        key.append(row.begin(), row.end());
+    return key;
 }
 
-// ------------------------------------------------------------------
-// GameBoard Implementation
-
 GameBoard::GameBoard(QWidget *parent, int mode)
-    : QWidget(parent), currentPlayer('X'), gameActive(true), gameMode(mode)
+    : QWidget(parent), currentPlayer('X'), gameActive(true), gameMode(mode), prover(kAiProofTableBytes),
+      ponderGeneration(0), analysisMode(false)
 {
     mainLayout = new QGridLayout(this);
     mainLayout->setSpacing(0);
@@ -52,6 +50,8 @@ GameBoard::GameBoard(QWidget *parent, int mode)
 
 GameBoard::~GameBoard()
 {
+    stopPondering();
+    ponderPool.waitForDone();
     for (auto& row : buttons) {
         for (auto& button : row)
             delete button;
@@ -94,8 +94,13 @@ void GameBoard::resetBoard()
         }
     currentPlayer = 'X';
     gameActive = true;
+    threats.clear();
+    if (analysisMode)
+        updateHeatmap();
     if (gameMode == 2 && currentPlayer == 'O')
         QTimer::singleShot(100, this, &GameBoard::triggerAiMove);
+    else if (gameMode == 2)
+        startPondering();
 }
 
 bool GameBoard::makeMove(int row, int col, char player)
@@ -105,6 +110,9 @@ bool GameBoard::makeMove(int row, int col, char player)
     {
         board[row][col] = player;
         updateButtonText(row, col, player);
+        threats.play(row * 3 + col, player);
+        if (analysisMode)
+            updateHeatmap();
         return true;
     }
     return false;
@@ -112,35 +120,12 @@ bool GameBoard::makeMove(int row, int col, char player)
 
 bool GameBoard::checkWinner(char player)
 {
-    for (int i = 0; i < 3; ++i)
-    {
-        if (board[i][0] == player &&
-            board[i][1] == player &&
-            board[i][2] == player)
-            return true;
-        if (board[0][i] == player &&
-            board[1][i] == player &&
-            board[2][i] == player)
-            return true;
-    }
-    if (board[0][0] == player &&
-        board[1][1] == player &&
-        board[2][2] == player)
-        return true;
-    if (board[0][2] == player &&
-        board[1][1] == player &&
-        board[2][0] == player)
-        return true;
-    return false;
+    return evalIsWinner(board, player);
 }
 
 bool GameBoard::isFull()
 {
-    for (const auto &row : board)
-        for (char cell : row)
-            if (cell == ' ')
-                return false;
-    return true;
+    return evalIsFull(board);
 }
 
 void GameBoard::switchPlayer()
@@ -149,11 +134,13 @@ void GameBoard::switchPlayer()
     qDebug() << "switchPlayer: Current player is now" << currentPlayer;
     if (gameMode == 2 && currentPlayer == 'O' && gameActive)
         triggerAiMove();
+    else if (gameMode == 2 && gameActive)
+        startPondering();
 }
 
 char GameBoard::getCurrentPlayer() const { return currentPlayer; }
 
-std::vector<std::vector<char>> GameBoard::getBoard() const { return board; }
+const BoardState& GameBoard::getBoard() const { return board; }
 
 bool GameBoard::isEmpty(int row, int col) const
 {
@@ -178,6 +165,7 @@ void GameBoard::disableBoard()
         for (int col = 0; col < 3; ++col)
             buttons[row][col]->setEnabled(false);
     gameActive = false;
+    stopPondering();
 }
 
 void GameBoard::enableBoard()
@@ -188,6 +176,55 @@ void GameBoard::enableBoard()
     gameActive = true;
 }
 
+void GameBoard::setAnalysisMode(bool enabled)
+{
+    analysisMode = enabled;
+    updateHeatmap();
+}
+
+void GameBoard::updateHeatmap()
+{
+    const QString plainStyle = "QPushButton { background-color: #f0f0f0; border: 1px solid #ccc; }";
+    const bool decided = evalIsWinner(board, 'X') || evalIsWinner(board, 'O');
+    SearchBoard flat = toSearchBoard(board);
+    MoveList moves;
+    generateMoves(flat, moves);
+    // X always starts, so the side to move follows from the stone count.
+    const char mover = (moves.count % 2 == 1) ? 'X' : 'O';
+
+    int maxThreat = 1;
+    for (int i = 0; i < moves.count; ++i)
+        maxThreat = std::max(maxThreat, threats.cellScore(moves.cells[i], mover));
+
+    for (int i = 0; i < moves.count; ++i)
+    {
+        const int cell = moves.cells[i];
+        QPushButton *button = buttons[cell / 3][cell % 3];
+        if (!analysisMode || decided)
+        {
+            button->setStyleSheet(plainStyle);
+            button->setToolTip("");
+            continue;
+        }
+        flat.cells[cell] = mover;
+        int value = minimaxCache.score(flat, mover == 'X' ? 'O' : 'X'); // positive favours 'O'
+        flat.cells[cell] = ' ';
+        if (mover == 'X')
+            value = -value;
+
+        // Threat scores grow geometrically, so shade on a log scale.
+        const int threat = threats.cellScore(cell, mover);
+        const double strength = std::log1p(threat) / std::log1p(maxThreat);
+        const int hue = value > 0 ? 120 : (value < 0 ? 0 : 45);
+        const QColor colour = QColor::fromHsv(hue, 40 + static_cast<int>(180 * strength), 245);
+        button->setStyleSheet(QString("QPushButton { background-color: %1; border: 1px solid #ccc; }").arg(colour.name()));
+        button->setToolTip(QString("%1 for %2 (threat score %3)")
+                               .arg(value > 0 ? "Win" : (value < 0 ? "Loss" : "Draw"))
+                               .arg(QChar(mover))
+                               .arg(threat));
+    }
+}
+
 void GameBoard::onCellClicked()
 {
     QPushButton* clickedButton = qobject_cast<QPushButton*>(sender());
@@ -214,6 +251,9 @@ void GameBoard::onCellClicked()
 
     if (makeMove(row, col, currentPlayer))
     {
+        // Only the search for this move is still useful.
+        if (gameMode == 2)
+            stopPondering(boardKey(board));
         emit moveMade(row, col, currentPlayer);
         if (checkWinner(currentPlayer))
         {
@@ -242,7 +282,8 @@ void GameBoard::triggerAiMove()
     if (!gameActive || currentPlayer != 'O' || gameMode != 2)
         return;
     qDebug() << "triggerAiMove: AI's turn, calling aiMove";
-    QTimer::singleShot(100, this, &GameBoard::aiMove);
+    // A pondered reply is played at once; otherwise give the UI a moment.
+    QTimer::singleShot(ponderedReply().x() != -1 ? 0 : 100, this, &GameBoard::aiMove);
 }
 
 void GameBoard::aiMove()
@@ -251,7 +292,9 @@ void GameBoard::aiMove()
         return;
     qDebug() << "aiMove: AI is making a move";
 
-    QPoint bestMove = findBestMove();
+    QPoint bestMove = ponderedReply();
+    if (bestMove.x() == -1)
+        bestMove = findBestMove();
     if (bestMove.x() != -1 && bestMove.y() != -1)
     {
         makeMove(bestMove.x(), bestMove.y(), currentPlayer);
@@ -282,71 +325,264 @@ void GameBoard::aiMove()
 // ------------------------------------------------------------------
 // Enhanced AI using minimax
 
-int GameBoard::minimax(std::vector<std::vector<char>> currentBoard, char player) {
-    if (evalIsWinner(currentBoard, 'O'))
-        return 10;
-    if (evalIsWinner(currentBoard, 'X'))
-        return -10;
-    if (evalIsFull(currentBoard))
-        return 0;
-
-    if (player == 'O') { // Maximizing
-        int bestScore = -1000;
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                if (currentBoard[i][j] == ' ') {
-                    currentBoard[i][j] = 'O';
-                    int score = minimax(currentBoard, 'X');
-                    currentBoard[i][j] = ' ';
-                    bestScore = std::max(bestScore, score);
-                }
+int GameBoard::minimax(BoardState& currentBoard, char player) {
+    return evalMinimax(currentBoard, player);
+}
+
+void GameBoard::startPondering()
+{
+    stopPondering();
+    const int generation = ponderGeneration;
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 3; ++col)
+        {
+            if (board[row][col] != ' ')
+                continue;
+            BoardState next = board;
+            next[row][col] = 'X';
+            if (evalIsWinner(next, 'X') || evalIsFull(next))
+                continue;
+            const std::string key = boardKey(next);
+            {
+                QMutexLocker lock(&ponderMutex);
+                if (ponderReplies.count(key))
+                    continue;
             }
-        }
-        return bestScore;
-    } else { // Minimizing (player 'X')
-        int bestScore = 1000;
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                if (currentBoard[i][j] == ' ') {
-                    currentBoard[i][j] = 'X';
-                    int score = minimax(currentBoard, 'O');
-                    currentBoard[i][j] = ' ';
-                    bestScore = std::min(bestScore, score);
+            QtConcurrent::run(&ponderPool, [this, next, key, generation]() {
+                if (ponderGeneration != generation)
+                {
+                    QMutexLocker lock(&ponderMutex);
+                    if (key != ponderKept)
+                        return;
                 }
-            }
+                int bestRow = -1, bestCol = -1;
+                if (!evalBestMove(next, bestRow, bestCol))
+                    return;
+                QMutexLocker lock(&ponderMutex);
+                ponderReplies[key] = QPoint(bestRow, bestCol);
+            });
         }
-        return bestScore;
     }
 }
 
+void GameBoard::stopPondering(const std::string &keep)
+{
+    {
+        QMutexLocker lock(&ponderMutex);
+        ponderKept = keep;
+    }
+    ++ponderGeneration;
+    // With a search to keep, the queue stays and the others return at once.
+    if (keep.empty())
+        ponderPool.clear();
+}
+
+QPoint GameBoard::ponderedReply()
+{
+    QMutexLocker lock(&ponderMutex);
+    auto it = ponderReplies.find(boardKey(board));
+    return it != ponderReplies.end() ? it->second : QPoint(-1, -1);
+}
+
 QPoint GameBoard::findBestMove() {
+    static const Variant variant = makeVariant(3, 3);
+    Position pos = { 0, 0 };
+    for (int row = 0; row < 3; ++row)
+        for (int col = 0; col < 3; ++col)
+            if (board[row][col] != ' ')
+                (board[row][col] == 'X' ? pos.x : pos.o) |= cellBit(row * 3 + col);
+
     int bestScore = -1000;
-    QPoint bestMove = { -1, -1 };
-    std::vector<std::vector<char>> boardCopy = board;
-
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            if (boardCopy[i][j] == ' ') {
-                boardCopy[i][j] = 'O'; // AI move candidate
-                int score = minimax(boardCopy, 'X');
-                boardCopy[i][j] = ' ';
-                if (score > bestScore) {
-                    bestScore = score;
-                    bestMove = { i, j };
-                }
-            }
-        }
+    int bestRow = -1, bestCol = -1;
+    AllocationScope allocations;
+    const ProofResult proof = prover.solve(variant, pos, kAiProofNodes);
+    if (proof.value != PROOF_UNKNOWN)
+        qDebug() << "findBestMove: df-pn proved a" << proofValueName(proof.value) << "in" << proof.nodes << "nodes";
+    if (proof.value == PROOF_WIN)
+    {
+        bestRow = proof.cell / 3;
+        bestCol = proof.cell % 3;
+        bestScore = 10; // searchMinimax's score for a win by 'O'
     }
+    else
+    {
+        evalBestMove(board, bestRow, bestCol, &bestScore);
+    }
+    const uint64_t searchAllocations = allocations.allocations();
+    QPoint bestMove = { bestRow, bestCol };
     qDebug() << "findBestMove: Chosen move at" << bestMove.x() << bestMove.y()
              << "with score" << bestScore;
+    if (allocationTrackingEnabled())
+    {
+        qDebug() << "findBestMove:" << searchAllocations << "heap allocations during search";
+        if (searchAllocations > 0)
+            qWarning() << "findBestMove: the AI search allocated on the heap";
+    }
     return bestMove;
 }
 
+// ------------------------------------------------------------------
+// UltimateBoard Implementation
+
+UltimateBoard::UltimateBoard(QWidget *parent, int aiTimeMs)
+    : QWidget(parent), gameActive(true), aiTime(aiTimeMs), aiGeneration(0)
+{
+    mainLayout = new QGridLayout(this);
+    mainLayout->setSpacing(1);
+    buttons.assign(81, nullptr);
+    for (int row = 0; row < 9; ++row)
+    {
+        for (int col = 0; col < 9; ++col)
+        {
+            const int move = ultimateMoveAt(row, col);
+            QPushButton *button = new QPushButton(this);
+            button->setFixedSize(40, 40);
+            button->setProperty("move", move);
+            // Grid rows and columns 3 and 7 stay empty to separate the sub-boards.
+            mainLayout->addWidget(button, row + row / 3, col + col / 3);
+            connect(button, &QPushButton::clicked, this, &UltimateBoard::onCellClicked);
+            buttons[move] = button;
+        }
+    }
+    for (int gap : { 3, 7 })
+    {
+        mainLayout->setRowMinimumHeight(gap, 8);
+        mainLayout->setColumnMinimumWidth(gap, 8);
+    }
+    connect(&aiWatcher, &QFutureWatcher<UltimateSearchResult>::finished, this, &UltimateBoard::onAiMoveFinished);
+    resetBoard();
+}
+
+UltimateBoard::~UltimateBoard()
+{
+    // A running search ends by itself within its time budget.
+    aiWatcher.waitForFinished();
+    for (QPushButton *button : buttons)
+        delete button;
+    buttons.clear();
+    delete mainLayout;
+}
+
+void UltimateBoard::resetBoard()
+{
+    ++aiGeneration;
+    ultimateReset(position);
+    gameActive = true;
+    updateBoard();
+}
+
+void UltimateBoard::disableBoard()
+{
+    gameActive = false;
+    updateBoard();
+}
+
+void UltimateBoard::enableBoard()
+{
+    gameActive = true;
+    updateBoard();
+}
+
+void UltimateBoard::setAiTime(int ms)
+{
+    aiTime = ms;
+}
+
+void UltimateBoard::onCellClicked()
+{
+    QPushButton* clickedButton = qobject_cast<QPushButton*>(sender());
+    if (!clickedButton || !gameActive || position.toMove != 'X' || aiWatcher.isRunning())
+        return;
+    const int move = clickedButton->property("move").toInt();
+    if (!ultimateIsLegal(position, move))
+        return;
+    playMove(move);
+    startAiMove();
+}
+
+void UltimateBoard::playMove(int move)
+{
+    const char player = position.toMove;
+    ultimatePlay(position, move);
+    emit moveMade(ultimateRow(move), ultimateCol(move), player);
+    const char winner = ultimateWinner(position);
+    if (winner != ' ')
+    {
+        gameActive = false;
+        updateBoard();
+        emit gameOver(winner == 'D' ? "Draw" : (winner == 'X' ? "You" : "AI"));
+        return;
+    }
+    updateBoard();
+}
+
+void UltimateBoard::startAiMove()
+{
+    if (!gameActive || position.toMove != 'O' || aiWatcher.isRunning())
+        return;
+    const UltimatePosition snapshot = position;
+    const int budget = aiTime;
+    aiWatcher.setProperty("generation", aiGeneration);
+    aiWatcher.setFuture(QtConcurrent::run([snapshot, budget]() {
+        return ultimateSearch(snapshot, budget);
+    }));
+    updateBoard(); // locks the board while the AI thinks
+}
+
+void UltimateBoard::onAiMoveFinished()
+{
+    // Results for a game that has since been reset are stale.
+    if (aiWatcher.property("generation").toInt() != aiGeneration || !gameActive)
+    {
+        updateBoard();
+        return;
+    }
+    const UltimateSearchResult result = aiWatcher.result();
+    qDebug() << "Ultimate AI: move" << result.move << "score" << result.score << "depth" << result.depth
+             << "nodes" << result.nodes;
+    if (result.move >= 0 && ultimateIsLegal(position, result.move))
+        playMove(result.move);
+    else
+        updateBoard();
+}
+
+void UltimateBoard::updateBoard()
+{
+    const bool humanTurn = gameActive && position.toMove == 'X' && !aiWatcher.isRunning();
+    for (int move = 0; move < 81; ++move)
+    {
+        const int board = move / 9;
+        const uint16_t bit = 1 << (move % 9);
+        const char stone = (position.x[board] & bit) ? 'X' : ((position.o[board] & bit) ? 'O' : ' ');
+        QString background = "#f0f0f0";
+        if (position.metaX & (1 << board))
+            background = "#cfe9fb";
+        else if (position.metaO & (1 << board))
+            background = "#fdd9c9";
+        else if (position.metaClosed & (1 << board))
+            background = "#d8d8d8";
+        else if (stone == 'X')
+            background = "#87CEFA";
+        else if (stone == 'O')
+            background = "#FFA07A";
+
+        const bool legal = humanTurn && ultimateIsLegal(position, move);
+        if (legal)
+            background = "#fff5bf";
+        QPushButton *button = buttons[move];
+        button->setText(stone == ' ' ? QString() : QString(QChar(stone)));
+        button->setEnabled(legal);
+        button->setStyleSheet(QString("QPushButton { background-color: %1; border: 1px solid #ccc; font: 16px; }")
+                                  .arg(background));
+    }
+}
+
 // ------------------------------------------------------------------
 // GameDialog Implementation
 
 GameDialog::GameDialog(QWidget *parent)
-    : QDialog(parent), gameBoard(nullptr), gameMode(0)
+    : QDialog(parent), gameBoard(nullptr), ultimateBoard(nullptr), gameMode(0)
 {
     this->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     mainLayout = new QGridLayout(this);
@@ -355,7 +591,15 @@ GameDialog::GameDialog(QWidget *parent)
 
     pvpButton = new QPushButton("PvP (Two Players)", this);
     pvaiButton = new QPushButton("PvAI (Play against AI)", this);
+    ultimateButton = new QPushButton("Ultimate (vs AI)", this);
     replayButton = new QPushButton("Replay Game", this);
+    analysisCheckBox = new QCheckBox("Show analysis heatmap", this);
+    aiTimeSpinBox = new QSpinBox(this);
+    aiTimeSpinBox->setRange(50, 10000);
+    aiTimeSpinBox->setSingleStep(50);
+    aiTimeSpinBox->setValue(1000);
+    aiTimeSpinBox->setPrefix("Ultimate AI time: ");
+    aiTimeSpinBox->setSuffix(" ms per move");
 
     // ComboBox will display only game numbers.
     comboBoxGameList = new QComboBox(this);
@@ -366,14 +610,26 @@ GameDialog::GameDialog(QWidget *parent)
     verticalLayout->addWidget(comboBoxGameList);
     verticalLayout->addWidget(replayButton);
     verticalLayout->addLayout(buttonLayout);
+    verticalLayout->addWidget(analysisCheckBox);
+    verticalLayout->addWidget(aiTimeSpinBox);
     buttonLayout->addWidget(pvpButton);
     buttonLayout->addWidget(pvaiButton);
+    buttonLayout->addWidget(ultimateButton);
     mainLayout->addLayout(verticalLayout, 0, 0);
 
     // Connect these buttons manually only once.
     connect(pvpButton, &QPushButton::clicked, this, &GameDialog::on_pvpButton_clicked);
     connect(pvaiButton, &QPushButton::clicked, this, &GameDialog::on_pvaiButton_clicked);
+    connect(ultimateButton, &QPushButton::clicked, this, &GameDialog::on_ultimateButton_clicked);
     connect(replayButton, &QPushButton::clicked, this, &GameDialog::on_replayButton_clicked);
+    connect(analysisCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+        if (gameBoard)
+            gameBoard->setAnalysisMode(checked);
+    });
+    connect(aiTimeSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int ms) {
+        if (ultimateBoard)
+            ultimateBoard->setAiTime(ms);
+    });
 
     player1Name = "Player 1";
     player2Name = "Player 2";
@@ -383,10 +639,15 @@ GameDialog::~GameDialog()
 {
     if (gameBoard)
         delete gameBoard;
+    if (ultimateBoard)
+        delete ultimateBoard;
     delete pvpButton;
     delete pvaiButton;
+    delete ultimateButton;
     delete replayButton;
     delete comboBoxGameList;
+    delete analysisCheckBox;
+    delete aiTimeSpinBox;
     delete buttonLayout;
     delete verticalLayout;
     delete mainLayout;
@@ -411,16 +672,40 @@ void GameDialog::on_pvaiButton_clicked()
     startGame(2);
 }
 
+void GameDialog::on_ultimateButton_clicked()
+{
+    player1Name = QInputDialog::getText(this, "Player Name", "Enter your name:", QLineEdit::Normal, "Player");
+    if (player1Name.isEmpty())
+        player1Name = "Player";
+    startGame(3);
+}
+
 void GameDialog::startGame(int mode)
 {
     gameMode = mode;
     if (gameBoard)
         delete gameBoard;
-    gameBoard = new GameBoard(this, gameMode);
-    connect(gameBoard, &GameBoard::moveMade, this, &GameDialog::recordMove);
-    connect(gameBoard, &GameBoard::gameOver, this, &GameDialog::onGameOver);
-    mainLayout->addWidget(gameBoard, 1, 0);
-    gameBoard->show();
+    gameBoard = nullptr;
+    if (ultimateBoard)
+        delete ultimateBoard;
+    ultimateBoard = nullptr;
+    if (gameMode == 3)
+    {
+        ultimateBoard = new UltimateBoard(this, aiTimeSpinBox->value());
+        connect(ultimateBoard, &UltimateBoard::moveMade, this, &GameDialog::recordMove);
+        connect(ultimateBoard, &UltimateBoard::gameOver, this, &GameDialog::onGameOver);
+        mainLayout->addWidget(ultimateBoard, 1, 0);
+        ultimateBoard->show();
+    }
+    else
+    {
+        gameBoard = new GameBoard(this, gameMode);
+        connect(gameBoard, &GameBoard::moveMade, this, &GameDialog::recordMove);
+        connect(gameBoard, &GameBoard::gameOver, this, &GameDialog::onGameOver);
+        gameBoard->setAnalysisMode(analysisCheckBox->isChecked());
+        mainLayout->addWidget(gameBoard, 1, 0);
+        gameBoard->show();
+    }
     moves.clear();
     this->adjustSize();
 }
@@ -440,14 +725,28 @@ void GameDialog::onGameOver(const QString& winner)
     QMessageBox::information(this, "Game Over", message);
 
     GameRecord record;
-    record.mode = (gameMode == 1) ? "PvP" : "PvAI";
+    record.mode = (gameMode == 1) ? "PvP" : (gameMode == 3 ? kUltimateMode : "PvAI");
     record.winner = winner.toStdString();
     record.moves = moves;
-    MainWindow::gameHistory.push_back(record);
-    MainWindow::saveGameHistory();
+    MainWindow::recordGame(record);
+    if (!MainWindow::positionIndex.addGame(record))
+    {
+        qWarning() << "Cannot append to the position index - rebuilding it.";
+        MainWindow::positionIndex.rebuild(MainWindow::getPositionIndexFilePath().toStdString(),
+                                          MainWindow::gameHistory);
+    }
+    MainWindow::analyseHistoryInBackground();
 
-    gameBoard->resetBoard();
-    gameBoard->enableBoard();
+    if (gameBoard)
+    {
+        gameBoard->resetBoard();
+        gameBoard->enableBoard();
+    }
+    if (ultimateBoard)
+    {
+        ultimateBoard->resetBoard();
+        ultimateBoard->enableBoard();
+    }
     moves.clear();
 }
 
@@ -482,7 +781,9 @@ void GameDialog::onComboBoxActivated(int index)
         QMessageBox::warning(this, "Replay", "No move data available for this game.");
         return;
     }
-    ReplayDialog* replayDialog = new ReplayDialog(record.moves, this);
+    ReplayDialog* replayDialog = isUltimateRecord(record)
+        ? new ReplayDialog(record.moves, std::vector<MoveEvaluation>(), 9, this)
+        : new ReplayDialog(record.moves, MainWindow::analysisFor(record), 3, this);
     replayDialog->exec();
     delete replayDialog;
 }
@@ -539,6 +840,20 @@ void HistoryDialog::displayGameHistory()
                                .arg(i + 1)
                                .arg(QString::fromStdString(record.mode))
                                .arg(QString::fromStdString(record.winner));
+        auto analysis = MainWindow::analysisCache.find(gameRecordKey(record));
+        if (analysis != MainWindow::analysisCache.end())
+        {
+            int blunders = 0, missedWins = 0;
+            for (const MoveEvaluation &evaluation : analysis->second)
+            {
+                MoveVerdict verdict = moveVerdict(evaluation);
+                if (verdict == VERDICT_BLUNDER)
+                    blunders++;
+                else if (verdict == VERDICT_MISSED_WIN)
+                    missedWins++;
+            }
+            gameInfo += QString(", Blunders: %1, Missed wins: %2").arg(blunders).arg(missedWins);
+        }
         historyTextEdit->append(gameInfo);
     }
     historyTextEdit->verticalScrollBar()->setValue(historyTextEdit->verticalScrollBar()->maximum());
@@ -552,15 +867,28 @@ void HistoryDialog::on_closeButton_clicked()
 // ------------------------------------------------------------------
 // ReplayDialog Implementation
 
-ReplayDialog::ReplayDialog(const std::vector<Move>& moves, QWidget *parent)
-    : QDialog(parent), movesToReplay(moves), moveIndex(0)
+ReplayDialog::ReplayDialog(const std::vector<Move>& moves, const std::vector<MoveEvaluation>& evaluations,
+                           int boardSize, QWidget *parent)
+    : QDialog(parent), boardSize(boardSize == 9 ? 9 : 3), movesToReplay(moves), moveEvaluations(evaluations),
+      replayBoard(emptyBoard()), moveIndex(0)
 {
     this->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     setWindowTitle("Animated Replay");
+    ultimateReset(ultimateReplay);
     boardLayout = new QGridLayout(this);
     initializeBoard();
+    // Below the grid, which has two spacer rows between sub-boards when 9x9.
+    const int gridRows = this->boardSize == 9 ? 11 : 3;
+    evaluationLabel = new QLabel("", this);
+    evaluationLabel->setAlignment(Qt::AlignCenter);
+    evaluationLabel->setMinimumHeight(40);
+    boardLayout->addWidget(evaluationLabel, gridRows, 0, 1, gridRows);
+    positionLabel = new QLabel("", this);
+    positionLabel->setAlignment(Qt::AlignCenter);
+    positionLabel->setWordWrap(true);
+    boardLayout->addWidget(positionLabel, gridRows + 1, 0, 1, gridRows);
     closeButton = new QPushButton("Close", this);
-    boardLayout->addWidget(closeButton, 3, 0, 1, 3);
+    boardLayout->addWidget(closeButton, gridRows + 2, 0, 1, gridRows);
     connect(closeButton, &QPushButton::clicked, this, &ReplayDialog::on_closeButton_clicked);
     timer = new QTimer(this);
     connect(timer, &QTimer::timeout, this, &ReplayDialog::playNextMove);
@@ -574,19 +902,59 @@ ReplayDialog::~ReplayDialog()
 
 void ReplayDialog::initializeBoard()
 {
-    cellLabels.resize(9);
-    for (int i = 0; i < 9; ++i)
+    const int cellSize = boardSize == 9 ? 40 : 80;
+    cellLabels.resize(boardSize * boardSize);
+    for (size_t i = 0; i < cellLabels.size(); ++i)
     {
         cellLabels[i] = new QLabel("", this);
-        cellLabels[i]->setFixedSize(80, 80);
+        cellLabels[i]->setFixedSize(cellSize, cellSize);
         cellLabels[i]->setFrameStyle(QFrame::Box | QFrame::Plain);
         cellLabels[i]->setAlignment(Qt::AlignCenter);
-        cellLabels[i]->setStyleSheet("font: 24px; background-color: #f0f0f0;");
+        cellLabels[i]->setStyleSheet(QString("font: %1px; background-color: #f0f0f0;").arg(cellSize * 3 / 10));
     }
     int index = 0;
-    for (int row = 0; row < 3; ++row)
-        for (int col = 0; col < 3; ++col)
-            boardLayout->addWidget(cellLabels[index++], row, col);
+    for (int row = 0; row < boardSize; ++row)
+        for (int col = 0; col < boardSize; ++col)
+            boardLayout->addWidget(cellLabels[index++], row + row / 3, col + col / 3);
+    if (boardSize == 9)
+    {
+        for (int gap : { 3, 7 })
+        {
+            boardLayout->setRowMinimumHeight(gap, 8);
+            boardLayout->setColumnMinimumWidth(gap, 8);
+        }
+    }
+}
+
+void ReplayDialog::playUltimateMove(const Move& m)
+{
+    const int move = ultimateMoveAt(m.row, m.col);
+    if (move < 0 || m.player != ultimateReplay.toMove || !ultimateIsLegal(ultimateReplay, move))
+        return;
+    const uint16_t closedBefore = ultimateReplay.metaClosed;
+    ultimatePlay(ultimateReplay, move);
+    const int cellSize = 40;
+    cellLabels[m.row * 9 + m.col]->setText(QString(QChar(m.player)));
+    cellLabels[m.row * 9 + m.col]->setStyleSheet(QString("font: %1px; background-color: %2; border: 1px solid #ccc;")
+                                                      .arg(cellSize * 3 / 10)
+                                                      .arg(m.player == 'X' ? "#87CEFA" : "#FFA07A"));
+    // Tint a sub-board once it is won or full, as on the live board.
+    const int board = move / 9;
+    if (!(closedBefore & (1 << board)) && (ultimateReplay.metaClosed & (1 << board)))
+    {
+        const char *tint = (ultimateReplay.metaX & (1 << board)) ? "#cfe9fb"
+                           : ((ultimateReplay.metaO & (1 << board)) ? "#fdd9c9" : "#d8d8d8");
+        for (int cell = 0; cell < 9; ++cell)
+        {
+            const int index = ultimateRow(board * 9 + cell) * 9 + ultimateCol(board * 9 + cell);
+            cellLabels[index]->setStyleSheet(QString("font: %1px; background-color: %2; border: 1px solid #ccc;")
+                                                 .arg(cellSize * 3 / 10)
+                                                 .arg(tint));
+        }
+    }
+    positionLabel->setText(QString("Sub-boards won: X %1, O %2")
+                               .arg(popCount(ultimateReplay.metaX))
+                               .arg(popCount(ultimateReplay.metaO)));
 }
 
 void ReplayDialog::playNextMove()
@@ -598,13 +966,46 @@ void ReplayDialog::playNextMove()
     }
     Move m = movesToReplay[moveIndex];
     int index = m.row * 3 + m.col;
-    if (index >= 0 && index < cellLabels.size())
+    if (boardSize == 9)
+    {
+        playUltimateMove(m);
+        evaluationLabel->setText(QString("Move %1: %2 at (%3, %4)").arg(moveIndex + 1).arg(QChar(m.player)).arg(m.row).arg(m.col));
+    }
+    else if (m.row >= 0 && m.row < 3 && m.col >= 0 && m.col < 3 && index < static_cast<int>(cellLabels.size()))
     {
         cellLabels[index]->setText(QString(QChar(m.player)));
         if (m.player == 'X')
             cellLabels[index]->setStyleSheet("font: 24px; background-color: #87CEFA; border: 1px solid #ccc;");
         else
             cellLabels[index]->setStyleSheet("font: 24px; background-color: #FFA07A; border: 1px solid #ccc;");
+        replayBoard[m.row][m.col] = m.player;
+        PositionStats stats = MainWindow::positionIndex.statsFrom(replayBoard);
+        if (stats.games > 0)
+            positionLabel->setText(QString("Reached in %1 of your games: X won %2%, O won %3%, drawn %4%")
+                                       .arg(stats.games)
+                                       .arg(100 * stats.xWins / stats.games)
+                                       .arg(100 * stats.oWins / stats.games)
+                                       .arg(100 * stats.draws / stats.games));
+        else
+            positionLabel->setText("Position not reached in your history");
+    }
+    if (moveIndex < static_cast<int>(moveEvaluations.size()))
+    {
+        const MoveEvaluation &evaluation = moveEvaluations[moveIndex];
+        QString text = QString("Move %1: %2 at (%3, %4)\n%5 -> %6")
+                           .arg(moveIndex + 1)
+                           .arg(QChar(m.player))
+                           .arg(m.row)
+                           .arg(m.col)
+                           .arg(valueName(evaluation.before))
+                           .arg(valueName(evaluation.after));
+        MoveVerdict verdict = moveVerdict(evaluation);
+        if (verdict == VERDICT_BLUNDER)
+            text += " (blunder)";
+        else if (verdict == VERDICT_MISSED_WIN)
+            text += " (missed win)";
+        evaluationLabel->setText(text);
+        evaluationLabel->setStyleSheet(verdict == VERDICT_GOOD ? "" : "color: #C0392B; font-weight: bold;");
     }
     moveIndex++;
 }
@@ -618,75 +1019,478 @@ void ReplayDialog::on_closeButton_clicked()
 // MainWindow Implementation with Password Reset Feature
 
 std::vector<GameRecord> MainWindow::gameHistory;
+std::unordered_map<uint64_t, std::vector<MoveEvaluation>> MainWindow::analysisCache;
+PositionIndex MainWindow::positionIndex;
+bool MainWindow::useTrieHistory = false;
+MoveTrie MainWindow::historyTrie;
+HistoryCache MainWindow::historyCache;
+Journal MainWindow::journal;
+std::vector<std::string> MainWindow::pendingRecords;
 QString MainWindow::currentUser = "";
-QString MainWindow::getHistoryFilePath() {
-    return currentUser + "_history.txt";
+QString MainWindow::getHistoryFilePath(const QString& user) {
+    return user + "_history.txt";
 }
 
-void MainWindow::saveGameHistory()
+QString MainWindow::getTrieHistoryFilePath(const QString& user) {
+    return user + "_history.trie";
+}
+
+QString MainWindow::getAnalysisFilePath() {
+    return currentUser + "_analysis.txt";
+}
+
+QString MainWindow::getPositionIndexFilePath() {
+    return currentUser + "_positions.idx";
+}
+
+// Result of analysing one record on the thread pool.
+struct AnalysisJob {
+    uint64_t key;
+    std::vector<MoveEvaluation> evaluations;
+};
+
+static AnalysisJob runAnalysisJob(const GameRecord &record)
+{
+    AnalysisJob job;
+    job.key = gameRecordKey(record);
+    analyseGame(record, job.evaluations); // keeps the legal prefix of broken records
+    return job;
+}
+
+void MainWindow::loadAnalysisCache()
 {
-    QFile file(getHistoryFilePath());
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+    analysisCache.clear();
+    QFile file(getAnalysisFilePath());
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
-        QTextStream out(&file);
-        for (const auto& record : gameHistory)
+        QTextStream in(&file);
+        while (!in.atEnd())
         {
-            // Save as: mode|winner|row-col-player;row-col-player;...
-            QString line = QString::fromStdString(record.mode) + "|" +
-                           QString::fromStdString(record.winner) + "|";
-            for (size_t i = 0; i < record.moves.size(); ++i)
+            uint64_t key;
+            std::vector<MoveEvaluation> evaluations;
+            if (decodeAnalysis(in.readLine().toStdString(), key, evaluations))
+                analysisCache[key] = evaluations;
+        }
+        file.close();
+    }
+}
+
+void MainWindow::storeAnalysis(uint64_t key, const std::vector<MoveEvaluation>& evaluations)
+{
+    if (!analysisCache.emplace(key, evaluations).second)
+        return;
+    // The cache file is append-only, so each game is analysed once per user.
+    QFile file(getAnalysisFilePath());
+    if (file.open(QIODevice::Append | QIODevice::Text))
+    {
+        QTextStream out(&file);
+        out << QString::fromStdString(encodeAnalysis(key, evaluations)) << "\n";
+        file.close();
+    }
+}
+
+void MainWindow::analyseHistoryInBackground()
+{
+    static QFutureWatcher<AnalysisJob>* watcher = nullptr;
+    static bool rerun = false;
+    if (watcher && watcher->isRunning())
+    {
+        rerun = true;
+        return;
+    }
+
+    std::vector<GameRecord> pending;
+    std::unordered_set<uint64_t> queued;
+    for (const GameRecord &record : gameHistory)
+    {
+        uint64_t key = gameRecordKey(record);
+        if (analysisCache.find(key) == analysisCache.end() && queued.insert(key).second)
+            pending.push_back(record);
+    }
+    if (pending.empty())
+        return;
+
+    if (!watcher)
+    {
+        watcher = new QFutureWatcher<AnalysisJob>(QCoreApplication::instance());
+        QObject::connect(watcher, &QFutureWatcher<AnalysisJob>::finished, watcher, []() {
+            // Drop results if the user signed out while the batch was running.
+            if (watcher->property("user").toString() == currentUser)
             {
-                const Move &m = record.moves[i];
-                line += QString::number(m.row) + "-" +
-                        QString::number(m.col) + "-" +
-                        QString(m.player);
-                if (i < record.moves.size() - 1)
-                    line += ";";
+                for (const AnalysisJob &job : watcher->future().results())
+                    storeAnalysis(job.key, job.evaluations);
             }
-            out << line << "\n";
+            if (rerun)
+            {
+                rerun = false;
+                analyseHistoryInBackground();
+            }
+        });
+    }
+    watcher->setProperty("user", currentUser);
+    watcher->setFuture(QtConcurrent::mapped(pending, runAnalysisJob));
+}
+
+std::vector<MoveEvaluation> MainWindow::analysisFor(const GameRecord& record)
+{
+    uint64_t key = gameRecordKey(record);
+    auto it = analysisCache.find(key);
+    if (it != analysisCache.end())
+        return it->second;
+    AnalysisJob job = runAnalysisJob(record);
+    storeAnalysis(job.key, job.evaluations);
+    return job.evaluations;
+}
+
+// ------------------------------------------------------------------
+// Write-ahead journal
+//
+// Every change to a history or to users.txt is first appended to
+// journal.wal as one checksummed record:
+//   G <user> <index> <game line>   game number index of a user's history
+//   U <user> <password>            account created or password changed
+// (fields separated by tabs). Checkpoints rewrite the main files from
+// these records and empty the journal. Applying a record twice is
+// harmless, so a crash between the two steps only repeats the work.
+
+static const char *kJournalPath = "journal.wal";
+static const size_t kCheckpointRecords = 64;
+
+struct JournalEntry {
+    char type;
+    QString user;
+    size_t index;
+    QString value;
+};
+
+static bool parseJournalEntry(const std::string &payload, JournalEntry &entry)
+{
+    const QStringList fields = QString::fromStdString(payload).split('\t');
+    if (fields.size() == 4 && fields[0] == "G")
+    {
+        bool ok = false;
+        entry.type = 'G';
+        entry.user = fields[1];
+        entry.index = fields[2].toULongLong(&ok);
+        entry.value = fields[3];
+        return ok;
+    }
+    if (fields.size() == 3 && fields[0] == "U")
+    {
+        entry.type = 'U';
+        entry.user = fields[1];
+        entry.index = 0;
+        entry.value = fields[2];
+        return true;
+    }
+    return false;
+}
+
+// Appends the journalled games of user that history does not have yet.
+static bool applyJournalGames(const std::vector<std::string> &records, const QString &user,
+                              std::vector<GameRecord> &history)
+{
+    bool changed = false;
+    JournalEntry entry;
+    GameRecord record;
+    for (const std::string &payload : records)
+    {
+        if (parseJournalEntry(payload, entry) && entry.type == 'G' && entry.user == user &&
+            entry.index == history.size() && decodeGameRecord(entry.value.toStdString(), record))
+        {
+            history.push_back(record);
+            changed = true;
         }
-        file.close();
     }
-    else
-        QMessageBox::critical(nullptr, "Error", "Could not write to history file.");
+    return changed;
 }
 
-void MainWindow::loadGameHistory()
+// Rewrites users.txt with the journalled account changes applied.
+static bool applyJournalUsers(const std::vector<std::string> &records)
 {
-    gameHistory.clear();
-    QFile file(getHistoryFilePath());
+    QStringList lines;
+    QFile file("users.txt");
     if (file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
         QTextStream in(&file);
         while (!in.atEnd())
+            lines << in.readLine();
+        file.close();
+    }
+
+    bool changed = false;
+    JournalEntry entry;
+    for (const std::string &payload : records)
+    {
+        if (!parseJournalEntry(payload, entry) || entry.type != 'U')
+            continue;
+        const QString line = entry.user + " " + entry.value;
+        bool found = false;
+        for (QString &existing : lines)
         {
-            QString line = in.readLine();
-            QStringList fields = line.split("|");
-            if (fields.size() < 2)
-                continue;
-            GameRecord record;
-            record.mode = fields[0].toStdString();
-            record.winner = fields[1].toStdString();
-            if (fields.size() == 3 && !fields[2].isEmpty())
+            QStringList parts = existing.split(' ');
+            if (parts.size() == 2 && parts[0] == entry.user)
             {
-                QStringList moveTokens = fields[2].split(";");
-                for (const QString &token : moveTokens)
-                {
-                    QStringList parts = token.split("-");
-                    if (parts.size() == 3)
-                    {
-                        Move m;
-                        m.row = parts[0].toInt();
-                        m.col = parts[1].toInt();
-                        m.player = parts[2].at(0).toLatin1();
-                        record.moves.push_back(m);
-                    }
-                }
+                changed = changed || existing != line;
+                existing = line;
+                found = true;
+                break;
             }
-            gameHistory.push_back(record);
+        }
+        if (!found)
+        {
+            lines << line;
+            changed = true;
+        }
+    }
+    if (!changed)
+        return true;
+
+    QSaveFile out("users.txt");
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream stream(&out);
+    for (const QString &line : lines)
+        stream << line << "\n";
+    stream.flush();
+    return out.commit();
+}
+
+std::vector<GameRecord> MainWindow::readHistoryFile(const QString& user, MoveTrie& trie, bool* ok)
+{
+    if (ok)
+        *ok = true;
+    const std::string triePath = getTrieHistoryFilePath(user).toStdString();
+    if (useTrieHistory)
+    {
+        bool missing = false;
+        if (trie.load(triePath, &missing))
+            return trie.games();
+        // The text file stopped being written at migration, so it must not
+        // stand in for a trie that exists but cannot be read.
+        if (!missing)
+        {
+            qWarning() << "Cannot read" << QString::fromStdString(triePath) << "- leaving it untouched.";
+            if (ok)
+                *ok = false;
+            return std::vector<GameRecord>();
+        }
+    }
+
+    std::vector<GameRecord> history;
+    QFile file(getHistoryFilePath(user));
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream in(&file);
+        while (!in.atEnd())
+        {
+            GameRecord record;
+            if (decodeGameRecord(in.readLine().toStdString(), record))
+                history.push_back(record);
         }
         file.close();
     }
+    // First sign-in in trie mode: migrate the text history.
+    if (useTrieHistory && !trie.migrate(triePath, history) && ok)
+        *ok = false;
+    return history;
+}
+
+bool MainWindow::writeHistoryFile(const QString& user, const std::vector<GameRecord>& history, MoveTrie& trie)
+{
+    if (useTrieHistory)
+    {
+        // The trie file is append-only: write just the games it lacks.
+        // A trie without a file was never read from disk: create the file if
+        // there is none, but never replace one it could not read.
+        const std::string triePath = getTrieHistoryFilePath(user).toStdString();
+        bool ok = true;
+        if (!trie.hasFile())
+            ok = trie.migrate(triePath, history);
+        else if (trie.gameCount() > history.size())
+            ok = trie.rebuild(triePath, history);
+        for (size_t i = trie.gameCount(); ok && i < history.size(); ++i)
+            ok = trie.addGame(history[i]);
+        // The journal is reset once this returns true, so the appends must
+        // be on disk by then (a rebuild already is).
+        return ok && trie.sync();
+    }
+
+    // QSaveFile replaces the file atomically, so a crash mid-write leaves
+    // the previous checkpoint intact.
+    QSaveFile file(getHistoryFilePath(user));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream out(&file);
+    for (const auto& record : history)
+        out << QString::fromStdString(encodeGameRecord(record)) << "\n";
+    out.flush();
+    return file.commit();
+}
+
+bool MainWindow::applyJournalRecords(const std::vector<std::string>& records)
+{
+    QStringList historyUsers;
+    bool usersChanged = false;
+    JournalEntry entry;
+    for (const std::string &payload : records)
+    {
+        if (!parseJournalEntry(payload, entry))
+            continue;
+        if (entry.type == 'U')
+            usersChanged = true;
+        else if (!historyUsers.contains(entry.user))
+            historyUsers << entry.user;
+    }
+
+    bool ok = true;
+    for (const QString &user : historyUsers)
+    {
+        if (user == currentUser)
+        {
+            // gameHistory already holds the journalled games.
+            ok = writeHistoryFile(user, gameHistory, historyTrie) && ok;
+            continue;
+        }
+        if (CachedHistory *cached = historyCache.find(user.toStdString()))
+        {
+            // Write through the cached copy so it keeps matching the file.
+            const bool added = applyJournalGames(records, user, cached->games);
+            ok = writeHistoryFile(user, cached->games, cached->trie) && ok;
+            cached->stamp = historyFileStamp(user);
+            // Its position index does not cover games added here.
+            if (added)
+                historyCache.erase(user.toStdString());
+            else
+                historyCache.remeasure(user.toStdString());
+            continue;
+        }
+        MoveTrie trie;
+        bool readable = true;
+        std::vector<GameRecord> history = readHistoryFile(user, trie, &readable);
+        if (!readable)
+        {
+            // Keep the records in the journal until the history can be read.
+            ok = false;
+            continue;
+        }
+        if (applyJournalGames(records, user, history))
+            ok = writeHistoryFile(user, history, trie) && ok;
+    }
+    if (usersChanged)
+        ok = applyJournalUsers(records) && ok;
+    return ok;
+}
+
+void MainWindow::recoverJournal()
+{
+    std::vector<std::string> records;
+    if (!journal.open(kJournalPath, records))
+    {
+        qWarning() << "Cannot open" << kJournalPath << "- writing history files directly.";
+        return;
+    }
+    pendingRecords = records;
+    checkpoint();
+}
+
+void MainWindow::checkpoint()
+{
+    if (pendingRecords.empty())
+        return;
+    // On failure the records stay in the journal and are retried later.
+    if (applyJournalRecords(pendingRecords) && journal.reset())
+        pendingRecords.clear();
+}
+
+void MainWindow::recordGame(const GameRecord& record)
+{
+    const std::string payload = "G\t" + currentUser.toStdString() + "\t" +
+                                std::to_string(gameHistory.size()) + "\t" + encodeGameRecord(record);
+    gameHistory.push_back(record);
+    if (!journal.append(payload))
+    {
+        saveGameHistory();
+        return;
+    }
+    pendingRecords.push_back(payload);
+    if (pendingRecords.size() >= kCheckpointRecords)
+        checkpoint();
+}
+
+bool MainWindow::journalUserChange(const QString &username, const QString &password)
+{
+    const std::string payload = "U\t" + username.toStdString() + "\t" + password.toStdString();
+    if (journal.append(payload))
+    {
+        pendingRecords.push_back(payload);
+        return true;
+    }
+    return applyJournalUsers(std::vector<std::string>(1, payload));
+}
+
+void MainWindow::saveGameHistory()
+{
+    if (!writeHistoryFile(currentUser, gameHistory, historyTrie))
+        QMessageBox::critical(nullptr, "Error", "Could not write to history file.");
+}
+
+qint64 MainWindow::historyFileStamp(const QString& user)
+{
+    QFileInfo info(useTrieHistory ? getTrieHistoryFilePath(user) : getHistoryFilePath(user));
+    if (!info.exists())
+        return -1;
+    return info.lastModified().toMSecsSinceEpoch() * 1000003 ^ info.size();
+}
+
+void MainWindow::stashCurrentUser()
+{
+    if (currentUser.isEmpty())
+        return;
+    CachedHistory entry;
+    entry.games = std::move(gameHistory);
+    entry.trie = std::move(historyTrie);
+    entry.positions = std::move(positionIndex);
+    entry.analysis = std::move(analysisCache);
+    entry.stamp = historyFileStamp(currentUser);
+    historyCache.put(currentUser.toStdString(), std::move(entry));
+    gameHistory.clear();
+    historyTrie.clear();
+    positionIndex.clear();
+    analysisCache.clear();
+}
+
+void MainWindow::loadGameHistory()
+{
+    CachedHistory cached;
+    // A changed stamp means another process wrote the file: reload it.
+    if (historyCache.take(currentUser.toStdString(), cached) && cached.stamp == historyFileStamp(currentUser))
+    {
+        gameHistory = std::move(cached.games);
+        historyTrie = std::move(cached.trie);
+        positionIndex = std::move(cached.positions);
+        analysisCache = std::move(cached.analysis);
+        qDebug() << "History of" << currentUser << "served from cache:" << historyCache.count() << "other users,"
+                 << historyCache.bytes() << "of" << historyCache.capacity() << "bytes";
+        analyseHistoryInBackground();
+        return;
+    }
+
+    bool readable = true;
+    gameHistory = readHistoryFile(currentUser, historyTrie, &readable);
+    if (!readable)
+        QMessageBox::warning(nullptr, "History",
+                             "Your game history file could not be read or created and has been left "
+                             "untouched. New games are kept in the journal until it can be.");
+    // Games still waiting in the journal after a failed checkpoint.
+    applyJournalGames(pendingRecords, currentUser, gameHistory);
+    // Game ids in the index are history positions, so rebuild it whenever
+    // the two disagree (first run, damaged file, history edited elsewhere).
+    const std::string indexPath = getPositionIndexFilePath().toStdString();
+    if (!positionIndex.load(indexPath) || positionIndex.gameCount() != gameHistory.size())
+        positionIndex.rebuild(indexPath, gameHistory);
+    loadAnalysisCache();
+    analyseHistoryInBackground();
 }
 
 MainWindow::MainWindow(QWidget *parent)
@@ -703,10 +1507,13 @@ MainWindow::MainWindow(QWidget *parent)
 
     gameDialog = new GameDialog(this);
     historyDialog = new HistoryDialog(this);
+
+    recoverJournal();
 }
 
 MainWindow::~MainWindow()
 {
+    checkpoint();
     delete ui;
     if (gameDialog)
         delete gameDialog;
@@ -717,44 +1524,16 @@ MainWindow::~MainWindow()
 // New function: Update user password in users.txt.
 void MainWindow::updateUserPassword(const QString &username, const QString &newPassword)
 {
-    QFile file("users.txt");
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        QMessageBox::critical(this, "Error", "Cannot open users.txt for reading.");
-        return;
-    }
-    QStringList lines;
-    QTextStream in(&file);
-    while (!in.atEnd())
-        lines << in.readLine();
-    file.close();
-
-    bool found = false;
-    for (int i = 0; i < lines.size(); i++)
-    {
-        QStringList parts = lines[i].split(' ');
-        if (parts.size() == 2 && parts[0] == username)
-        {
-            lines[i] = username + " " + newPassword;
-            found = true;
-            break;
-        }
-    }
-    if (!found)
+    if (loadUsers().count(username) == 0)
     {
         QMessageBox::critical(this, "Error", "User not found in file.");
         return;
     }
-
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    if (!journalUserChange(username, newPassword))
     {
         QMessageBox::critical(this, "Error", "Cannot open users.txt for writing.");
         return;
     }
-    QTextStream out(&file);
-    for (const QString &line : lines)
-        out << line << "\n";
-    file.close();
     QMessageBox::information(this, "Password Updated", "Your password has been updated successfully.");
 }
 
@@ -768,8 +1547,7 @@ void MainWindow::signInButtonClicked()
     {
         signInAttempts = 0;
         QMessageBox::information(this, "Sign In", "Sign in successful!");
-        currentUser = username;
-        loadGameHistory();
+        switchUser(username);
         ui->stackedWidget->setCurrentIndex(1);
     }
     else
@@ -790,8 +1568,7 @@ void MainWindow::signInButtonClicked()
                 {
                     updateUserPassword(username, newPassword);
                     signInAttempts = 0;
-                    currentUser = username;
-                    loadGameHistory();
+                    switchUser(username);
                     ui->stackedWidget->setCurrentIndex(1);
                 }
                 else
@@ -828,8 +1605,7 @@ void MainWindow::signUpButtonClicked()
     }
     saveUser(username, password);
     QMessageBox::information(this, "Sign Up", "Account created successfully!");
-    currentUser = username;
-    loadGameHistory();
+    switchUser(username);
     ui->stackedWidget->setCurrentIndex(1);
 }
 
@@ -856,22 +1632,29 @@ std::unordered_map<QString, QString> MainWindow::loadUsers()
         }
         file.close();
     }
+    // Account changes not yet checkpointed into users.txt.
+    JournalEntry entry;
+    for (const std::string &payload : pendingRecords)
+        if (parseJournalEntry(payload, entry) && entry.type == 'U')
+            users[entry.user] = entry.value;
     return users;
 }
 
 void MainWindow::saveUser(const QString& username, const QString& password)
 {
-    QFile file("users.txt");
-    if (file.open(QIODevice::Append | QIODevice::Text))
-    {
-        QTextStream out(&file);
-        out << username << " " << password << "\n";
-        file.close();
-    }
-    else
+    if (!journalUserChange(username, password))
         QMessageBox::critical(this, "Error", "Could not write to users.txt");
 }
 
+void MainWindow::switchUser(const QString &username)
+{
+    // Flush the previous user's games before gameHistory is replaced.
+    checkpoint();
+    stashCurrentUser();
+    currentUser = username;
+    loadGameHistory();
+}
+
 void MainWindow::playGameButtonClicked()
 {
     if (!gameDialog)
@@ -9,31 +9,32 @@
 #include <QTimer>
 #include <QTextEdit>
 #include <QComboBox>
+#include <QCheckBox>
+#include <QThreadPool>
+#include <QMutex>
+#include <QFutureWatcher>
+#include <QSpinBox>
+#include <atomic>
 #include <vector>
 #include <QString>
 #include <string>
 #include <unordered_map>
 
+#include "gamecore.h"
+#include "analysis.h"
+#include "positionindex.h"
+#include "movetrie.h"
+#include "journal.h"
+#include "allocstats.h"
+#include "threatmap.h"
+#include "historycache.h"
+#include "ultimate.h"
+#include "proofsearch.h"
+
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
-// --- Move Struct Definition ---
-// Records each move's row, column, and the player that moved.
-struct Move {
-    int row;
-    int col;
-    char player;
-};
-
-// --- GameRecord Struct Definition ---
-// Stores the game mode, winner and the full move history.
-struct GameRecord {
-    std::string mode;
-    std::string winner;
-    std::vector<Move> moves;
-};
-
 // --- GameBoard Class Definition ---
 // Handles the board UI and game logic including AI moves with minimax.
 class GameBoard : public QWidget
@@ -51,11 +52,13 @@ public:
     bool isFull();
     void switchPlayer();
     char getCurrentPlayer() const;
-    std::vector<std::vector<char>> getBoard() const;
+    const BoardState& getBoard() const;
     bool isEmpty(int row, int col) const;
     void updateButtonText(int row, int col, char text);
     void disableBoard();
     void enableBoard();
+    // Colours every empty cell by what it is worth to the side to move.
+    void setAnalysisMode(bool enabled);
 
 public slots:
     void onCellClicked();
@@ -75,8 +78,72 @@ private:
     int gameMode;
 
     QPoint findBestMove();
-    int minimax(std::vector<std::vector<char>> currentBoard, char player);
-    std::vector<QPoint> getAvailableMoves(const std::vector<std::vector<char>>& b);
+    int minimax(BoardState& currentBoard, char player);
+
+    // df-pn runs ahead of the minimax in findBestMove and plays a proven
+    // win straight away; its table persists across moves.
+    ProofSolver prover;
+
+    // Pondering: during the human's turn in PvAI the AI reply to every
+    // possible human move is searched on ponderPool, so aiMove() usually
+    // finds its answer in ponderReplies (keyed by board) without searching.
+    QThreadPool ponderPool;
+    QMutex ponderMutex;
+    std::unordered_map<std::string, QPoint> ponderReplies;
+    std::atomic<int> ponderGeneration;
+    std::string ponderKept; // board whose search survives stopPondering, under ponderMutex
+    void startPondering();
+    // Drops the searches that have not started yet, except the one for keep.
+    void stopPondering(const std::string &keep = std::string());
+    QPoint ponderedReply();
+
+    // Analysis heatmap: the exact result of each empty cell (win, draw or
+    // loss, memoised across moves and games) sets its hue, and the line
+    // threats through it, updated per move by ThreatMap, its saturation.
+    bool analysisMode;
+    ThreatMap threats;
+    MinimaxCache minimaxCache;
+    void updateHeatmap();
+};
+
+// --- UltimateBoard Class Definition ---
+// Ultimate tic-tac-toe against the AI (the player is X): nine 3x3 sub-boards
+// whose results form the meta-board. Moves are reported in 9x9 coordinates.
+// The AI searches on a worker thread and answers within its time budget.
+class UltimateBoard : public QWidget
+{
+    Q_OBJECT
+
+public:
+    UltimateBoard(QWidget *parent = nullptr, int aiTimeMs = 1000);
+    ~UltimateBoard();
+
+    void resetBoard();
+    void disableBoard();
+    void enableBoard();
+    void setAiTime(int ms);
+
+public slots:
+    void onCellClicked();
+    void onAiMoveFinished();
+
+signals:
+    void gameOver(const QString& winner);
+    void moveMade(int row, int col, char player);
+
+private:
+    void playMove(int move);
+    void startAiMove();
+    // Restyles every cell: stones, won sub-boards and where the player may move.
+    void updateBoard();
+
+    UltimatePosition position;
+    std::vector<QPushButton*> buttons; // indexed by move number
+    QGridLayout* mainLayout;
+    bool gameActive;
+    int aiTime;
+    QFutureWatcher<UltimateSearchResult> aiWatcher;
+    int aiGeneration; // a reset while the AI thinks discards its move
 };
 
 // --- GameDialog Class Definition ---
@@ -93,6 +160,7 @@ public:
 public slots:
     void on_pvpButton_clicked();
     void on_pvaiButton_clicked();
+    void on_ultimateButton_clicked();
     void on_replayButton_clicked();
     void onComboBoxActivated(int index); // Called when a game number is selected for replay
     void onGameOver(const QString& winner);
@@ -102,13 +170,17 @@ private:
     void startGame(int mode);
 
     GameBoard* gameBoard;
+    UltimateBoard* ultimateBoard;
     QGridLayout* mainLayout;
     QVBoxLayout* verticalLayout;
     QHBoxLayout* buttonLayout;
     QPushButton* pvpButton;
     QPushButton* pvaiButton;
+    QPushButton* ultimateButton;
     QPushButton* replayButton;
     QComboBox* comboBoxGameList;  // Displays only game numbers for replay
+    QCheckBox* analysisCheckBox;
+    QSpinBox* aiTimeSpinBox;      // ultimate AI budget per move
     QString player1Name;
     QString player2Name;
     int gameMode;
@@ -142,12 +214,15 @@ private:
 };
 
 // --- ReplayDialog Class Definition ---
-// Provides animated replay of a selected game record using a 3x3 grid.
+// Provides animated replay of a selected game record using a 3x3 grid (9x9
+// for ultimate games), showing the engine's evaluation of each move as it
+// is played.
 class ReplayDialog : public QDialog
 {
     Q_OBJECT
 public:
-    ReplayDialog(const std::vector<Move>& moves, QWidget* parent = nullptr);
+    ReplayDialog(const std::vector<Move>& moves, const std::vector<MoveEvaluation>& evaluations,
+                 int boardSize = 3, QWidget* parent = nullptr);
     ~ReplayDialog();
 
 private slots:
@@ -156,13 +231,20 @@ private slots:
 
 private:
     void initializeBoard();
+    void playUltimateMove(const Move& m);
 
     QGridLayout* boardLayout;
-    std::vector<QLabel*> cellLabels; // 9 labels for the game grid
+    std::vector<QLabel*> cellLabels; // boardSize * boardSize labels for the game grid
+    int boardSize;
     QTimer* timer;
     std::vector<Move> movesToReplay;
+    std::vector<MoveEvaluation> moveEvaluations; // may be shorter than movesToReplay
+    BoardState replayBoard;
+    UltimatePosition ultimateReplay; // 9x9 replays
     int moveIndex;
     QPushButton* closeButton;
+    QLabel* evaluationLabel;
+    QLabel* positionLabel;
 };
 
 // --- MainWindow Class Definition ---
@@ -178,13 +260,40 @@ public:
 
     // gameHistory pertains to the current user.
     static std::vector<GameRecord> gameHistory;
-    // Returns the file path for the current user's history.
-    static QString getHistoryFilePath();
+    // Returns the file path for a user's history (the current user by default).
+    static QString getHistoryFilePath(const QString& user = currentUser);
 
     // currentUser is set upon successful sign in.
     static QString currentUser;
 
     static void saveGameHistory();
+    // Appends a finished game to gameHistory and makes it durable with one
+    // journal append; the history file is brought up to date at checkpoints.
+    static void recordGame(const GameRecord& record);
+    // Applies the pending journal records to the history and user files,
+    // then empties the journal.
+    static void checkpoint();
+
+    // Stores history as a shared-prefix trie (<user>_history.trie) instead of
+    // one text line per game. Set from the command line in main().
+    static bool useTrieHistory;
+    static QString getTrieHistoryFilePath(const QString& user = currentUser);
+
+    // Recently signed-out users' state, so signing back in needs no file
+    // reads. Capacity can be set from the command line in main().
+    static HistoryCache historyCache;
+
+    // Move-by-move analysis of the current user's games, keyed by gameRecordKey().
+    static std::unordered_map<uint64_t, std::vector<MoveEvaluation>> analysisCache;
+    static QString getAnalysisFilePath();
+    // Analyses every game not yet in the cache on the global thread pool.
+    static void analyseHistoryInBackground();
+    // Returns the cached analysis of a record, analysing it now if needed.
+    static std::vector<MoveEvaluation> analysisFor(const GameRecord& record);
+
+    // Canonical position -> games of the current user that reached it.
+    static PositionIndex positionIndex;
+    static QString getPositionIndexFilePath();
 
 private slots:
     // Renamed slots to avoid auto‑connection conflicts.
@@ -202,8 +311,27 @@ private:
     std::unordered_map<QString, QString> loadUsers();
     void saveUser(const QString& username, const QString& password);
     void updateUserPassword(const QString &username, const QString &newPassword); // Updates user's password in users.txt
+    void switchUser(const QString &username);
 
     static void loadGameHistory();
+    // Moves the current user's state into historyCache.
+    static void stashCurrentUser();
+    // Changes whenever the user's history file is rewritten or appended to.
+    static qint64 historyFileStamp(const QString& user);
+    static MoveTrie historyTrie;
+    // Write-ahead journal for history and user changes (journal.wal) and
+    // the records it holds that are not yet in the main files.
+    static Journal journal;
+    static std::vector<std::string> pendingRecords;
+    static void recoverJournal();
+    static bool applyJournalRecords(const std::vector<std::string>& records);
+    static bool journalUserChange(const QString &username, const QString &password);
+    // ok is false when the history could not be read (or, on first use of
+    // trie mode, migrated); nothing may then be written back for the user.
+    static std::vector<GameRecord> readHistoryFile(const QString& user, MoveTrie& trie, bool* ok = nullptr);
+    static bool writeHistoryFile(const QString& user, const std::vector<GameRecord>& history, MoveTrie& trie);
+    static void loadAnalysisCache();
+    static void storeAnalysis(uint64_t key, const std::vector<MoveEvaluation>& evaluations);
 };
 
 #endif // MAINWINDOW_H
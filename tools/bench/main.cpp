@@ -0,0 +1,111 @@
+#include "winbatch.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <algorithm>
+#include <vector>
+
+// Random positions reached by alternating play, stopping at a random ply.
+static void randomPositions(const Variant &variant, int count, std::vector<CellMask> &xs, std::vector<CellMask> &os)
+{
+    QRandomGenerator random(12345);
+    xs.resize(count);
+    os.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Position pos = { 0, 0 };
+        int plies = random.bounded(variant.cells + 1);
+        for (int ply = 0; ply < plies; ++ply)
+        {
+            CellMask empty = emptyCells(variant, pos);
+            int skip = random.bounded(popCount(empty));
+            while (skip-- > 0)
+                empty &= empty - 1;
+            if (ply % 2 == 0)
+                pos.x |= empty & (~empty + 1);
+            else
+                pos.o |= empty & (~empty + 1);
+        }
+        xs[i] = pos.x;
+        os[i] = pos.o;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares the scalar and SIMD batched win-detection kernels.");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size", "Board size (size x size).", "n", "3");
+    QCommandLineOption kOption("k", "Stones in a row needed to win.", "k", "3");
+    QCommandLineOption boardsOption("boards", "Boards per batch.", "count", "1000000");
+    QCommandLineOption repeatOption("repeat", "Batches timed per kernel.", "count", "10");
+    parser.addOption(sizeOption);
+    parser.addOption(kOption);
+    parser.addOption(boardsOption);
+    parser.addOption(repeatOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    Variant variant = makeVariant(parser.value(sizeOption).toInt(), parser.value(kOption).toInt());
+    const int boards = std::max(1, parser.value(boardsOption).toInt());
+    const int repeat = std::max(1, parser.value(repeatOption).toInt());
+    if (variant.cells == 0)
+    {
+        out << "Invalid board size or k.\n";
+        return 1;
+    }
+
+    std::vector<CellMask> xs, os;
+    randomPositions(variant, boards, xs, os);
+    std::vector<uint8_t> referenceWins(boards), wins(boards);
+    std::vector<int32_t> referenceOpen(boards), open(boards);
+
+    out << variant.size << "x" << variant.size << " k=" << variant.k << ", " << variant.lines.size()
+        << " lines, " << boards << " boards x " << repeat << "\n";
+
+    bool ok = true;
+    const BatchKernel kernels[] = { BATCH_SCALAR, BATCH_SSE41, BATCH_AVX2 };
+    for (BatchKernel kernel : kernels)
+    {
+        setBatchKernel(kernel);
+        if (activeBatchKernel() != kernel)
+        {
+            out << batchKernelName(kernel) << ": not supported on this CPU\n";
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < repeat; ++r)
+            batchHasLine(variant, xs.data(), boards, wins.data());
+        const double winSeconds = timer.nsecsElapsed() / 1e9;
+
+        timer.restart();
+        for (int r = 0; r < repeat; ++r)
+            batchOpenLines(variant, os.data(), boards, open.data());
+        const double openSeconds = timer.nsecsElapsed() / 1e9;
+
+        if (kernel == BATCH_SCALAR)
+        {
+            referenceWins = wins;
+            referenceOpen = open;
+        }
+        const bool match = wins == referenceWins && open == referenceOpen;
+        ok = ok && match;
+
+        const double total = double(boards) * repeat;
+        out << qSetFieldWidth(8) << batchKernelName(kernel) << qSetFieldWidth(0)
+            << "  win check " << QString::number(total / winSeconds / 1e6, 'f', 1) << " M boards/s"
+            << "  open lines " << QString::number(total / openSeconds / 1e6, 'f', 1) << " M boards/s"
+            << (match ? "" : "  MISMATCH") << "\n";
+    }
+    setBatchKernel(BATCH_AUTO);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-fuzz
+
+SOURCES += \
+    fuzztargets.cpp
+
+HEADERS += \
+    fuzztargets.h
+
+# qmake CONFIG+=libfuzzer QMAKE_CXX=clang++ QMAKE_LINK=clang++ builds the
+# libFuzzer binary instead: no Qt, with address and undefined-behaviour
+# sanitizers. Seed it from tictactoe-fuzz --write-corpus.
+libfuzzer {
+    CONFIG -= qt
+    TARGET = tictactoe-libfuzzer
+    SOURCES += fuzzentry.cpp
+    QMAKE_CXXFLAGS += -g -fsanitize=fuzzer,address,undefined
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+} else {
+    QT = core concurrent
+    SOURCES += main.cpp
+}
+
+include(../../core/core.pri)
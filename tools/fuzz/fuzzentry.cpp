@@ -0,0 +1,23 @@
+#include "fuzztargets.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// libFuzzer entry point (qmake CONFIG+=libfuzzer). The first byte picks the
+// target, the rest is its input, the same layout tictactoe-fuzz writes for
+// failures and --write-corpus. A disagreement aborts so libFuzzer saves
+// the input as a crash.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size == 0)
+        return 0;
+    const int target = data[0] % FUZZ_TARGET_COUNT;
+    std::string failure;
+    if (!runFuzzTarget(target, data + 1, size - 1, failure))
+    {
+        std::fprintf(stderr, "%s: %s\n", fuzzTargetName(target), failure.c_str());
+        std::abort();
+    }
+    return 0;
+}
@@ -0,0 +1,871 @@
+#include "fuzztargets.h"
+#include "analysis.h"
+#include "bitboard.h"
+#include "gamecore.h"
+#include "journal.h"
+#include "movetrie.h"
+#include "neuralnet.h"
+#include "positionindex.h"
+#include "proofsearch.h"
+#include "search.h"
+#include "tablebase.h"
+#include "tictactoe.h"
+#include "ultimate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+namespace {
+
+const char *const kTargetNames[FUZZ_TARGET_COUNT] = {
+    "minimax", "kinarow", "ultimate", "record", "analysis", "journal", "movetrie", "positionindex", "network"
+};
+
+// Most empty cells left for the plain minimax reference on larger boards
+// (8! leaves at worst), and its node budget for ultimate endgames.
+const int kMaxReferenceEmpty = 8;
+const uint64_t kUltimateReferenceNodes = 200000;
+// df-pn budget and table for k-in-a-row endgames; the table is small so
+// that replacement is exercised too.
+const uint64_t kProofNodes = 20000;
+const size_t kProofTableBytes = 1 << 20;
+
+// Reads the input one byte at a time. Past the end every byte reads as 0,
+// so short inputs still describe a complete position.
+class ByteReader
+{
+public:
+    ByteReader(const uint8_t *data, size_t size) : data(data), size(size), offset(0) {}
+    unsigned next() { return offset < size ? data[offset++] : 0; }
+
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t offset;
+};
+
+struct GameDeleter {
+    void operator()(ttt_game *game) const { ttt_game_free(game); }
+};
+typedef std::unique_ptr<ttt_game, GameDeleter> GamePtr;
+
+// Files for the decoders that read from disk: one set per thread, removed
+// when the thread ends.
+class ScratchFiles
+{
+public:
+    ScratchFiles() {
+        std::error_code error;
+        std::filesystem::path dir = std::filesystem::temp_directory_path(error);
+        if (error)
+            dir = ".";
+        base = (dir / ("tictactoe-fuzz-" + std::to_string(std::random_device()()) + "-")).string();
+    }
+    ~ScratchFiles() {
+        for (const std::string &path : used)
+            std::remove(path.c_str());
+    }
+    std::string path(const std::string &name) {
+        const std::string full = base + name;
+        if (std::find(used.begin(), used.end(), full) == used.end())
+            used.push_back(full);
+        return full;
+    }
+
+private:
+    std::string base;
+    std::vector<std::string> used;
+};
+
+thread_local ScratchFiles scratch;
+
+bool writeFile(const std::string &path, const uint8_t *data, size_t size) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    return static_cast<bool>(out);
+}
+
+std::vector<uint8_t> readFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Printable form of a decoder input for failure messages.
+std::string quoted(const std::string &text) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string result = "\"";
+    for (size_t i = 0; i < text.size() && i < 160; ++i) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 32 && c < 127 && c != '"' && c != '\\') {
+            result += static_cast<char>(c);
+        } else {
+            result += "\\x";
+            result += kHex[c >> 4];
+            result += kHex[c & 15];
+        }
+    }
+    return result + (text.size() > 160 ? "...\"" : "\"");
+}
+
+std::string positionText(const Variant &variant, const Position &pos) {
+    std::string text;
+    for (int cell = 0; cell < variant.cells; ++cell)
+        text += (pos.x & cellBit(cell)) ? 'X' : ((pos.o & cellBit(cell)) ? 'O' : '.');
+    return text + " (" + sideToMove(pos) + " to move)";
+}
+
+std::string cellText(const Variant &variant, int cell) {
+    if (cell < 0)
+        return "no move";
+    return "(" + std::to_string(cell / variant.size) + ", " + std::to_string(cell % variant.size) + ")";
+}
+
+bool disagree(std::string &failure, const std::string &where, const std::string &engine,
+              const std::string &claim, int expected) {
+    failure = where + ": " + engine + " " + claim + ", reference minimax: " + valueName(expected);
+    return false;
+}
+
+int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+// 1 / -1 for a proven win / loss, 0 for an exact draw, 2 for anything else.
+int provenValue(int score, int winScore) {
+    if (score >= winScore)
+        return 1;
+    if (score <= -winScore)
+        return -1;
+    return score == 0 ? 0 : 2;
+}
+
+std::string scoreText(int score, int winScore) {
+    const int value = provenValue(score, winScore);
+    return "scores " + std::to_string(score) + (value == 2 ? " (unproven)" : std::string(" (") + valueName(value) + ")");
+}
+
+bool decided(const Variant &variant, const Position &pos) {
+    return hasLine(variant, pos.x) || hasLine(variant, pos.o) || emptyCells(variant, pos) == 0;
+}
+
+int nthCell(CellMask mask, int n) {
+    for (; n > 0; --n)
+        mask &= mask - 1;
+    return lowestCell(mask);
+}
+
+// Every variant the kinarow target plays: size 3..6, k 3..size.
+const Variant &fuzzVariant(int size, int k) {
+    static const std::vector<Variant> variants = [] {
+        std::vector<Variant> all;
+        for (int n = 3; n <= 6; ++n)
+            for (int line = 3; line <= 6; ++line)
+                all.push_back(makeVariant(n, std::min(line, n)));
+        return all;
+    }();
+    return variants[(size - 3) * 4 + (k - 3)];
+}
+
+const Tablebase &tablebase3x3() {
+    static Tablebase table;
+    static const bool opened = [] {
+        const std::string path = scratch.path("3x3.tb");
+        const bool ok = solveTablebase(makeVariant(3, 3), 1, path, nullptr, nullptr) && table.open(path);
+        std::remove(path.c_str()); // already mapped or read where that is allowed
+        return ok;
+    }();
+    (void)opened;
+    return table;
+}
+
+// ------------------------------------------------------------------
+// Engine targets
+
+// Value of playing cell for mover on a 3x3 board, by searchMinimax; 2 if
+// the move is not legal.
+int moveValue(SearchBoard board, int cell, char mover) {
+    if (cell < 0 || cell >= 9 || board.cells[cell] != ' ')
+        return 2;
+    board.cells[cell] = mover;
+    const int score = searchMinimax(board, mover == 'O' ? 'X' : 'O');
+    return mover == 'O' ? sign(score) : -sign(score);
+}
+
+bool checkMinimax(ByteReader &in, std::string &failure) {
+    static const Variant variant = makeVariant(3, 3);
+    thread_local MinimaxCache cache;
+    SearchBoard board;
+    std::fill(board.cells, board.cells + 9, ' ');
+    Position pos = { 0, 0 };
+    GamePtr game(ttt_game_new(3, 3));
+    if (!game) {
+        failure = "ttt_game_new(3, 3) failed";
+        return false;
+    }
+    const int plies = in.next() % 10;
+    for (int ply = 0; ply < plies && !decided(variant, pos); ++ply) {
+        MoveList moves;
+        generateMoves(board, moves);
+        const int cell = moves.cells[in.next() % moves.count];
+        const char player = sideToMove(pos);
+        board.cells[cell] = player;
+        (player == 'X' ? pos.x : pos.o) |= cellBit(cell);
+        if (ttt_game_play(game.get(), cell / 3, cell % 3) != TTT_OK) {
+            failure = positionText(variant, pos) + ": ttt_game_play rejected the last move";
+            return false;
+        }
+    }
+
+    const char mover = sideToMove(pos);
+    const std::string where = positionText(variant, pos);
+    SearchBoard copy = board;
+    const int reference = searchMinimax(copy, mover); // positive favours 'O'
+    const int value = mover == 'O' ? sign(reference) : -sign(reference);
+    copy = board;
+    const int cached = cache.score(copy, mover);
+    if (cached != reference)
+        return disagree(failure, where, "MinimaxCache", "scores " + std::to_string(cached), value);
+
+    EngineConfig config = { "", variant.cells, 0, true, nullptr, 0, 0, nullptr };
+    int row = -1, col = -1, score = 0;
+    if (decided(variant, pos)) {
+        if (searchMove(variant, pos, config).cell != -1 ||
+            ttt_game_best_move(game.get(), 0, 0, &row, &col, &score) != TTT_ERROR_ILLEGAL) {
+            failure = where + ": a move was found in a finished game";
+            return false;
+        }
+        return true;
+    }
+
+    if (mover == 'O') {
+        BoardState state = emptyBoard();
+        for (int cell = 0; cell < 9; ++cell)
+            state[cell / 3][cell % 3] = board.cells[cell];
+        if (!evalBestMove(state, row, col, &score) || score != reference)
+            return disagree(failure, where, "evalBestMove", "scores " + std::to_string(score), value);
+        if (moveValue(board, row * 3 + col, mover) != value)
+            return disagree(failure, where, "evalBestMove", "plays " + cellText(variant, row * 3 + col), value);
+    }
+
+    const int winScore = kSearchWinScore - variant.cells;
+    for (bool alphaBeta : { true, false }) {
+        config.alphaBeta = alphaBeta;
+        const SearchResult result = searchMove(variant, pos, config);
+        const char *engine = alphaBeta ? "searchMove" : "searchMove without alpha-beta";
+        if (provenValue(result.score, winScore) != value)
+            return disagree(failure, where, engine, scoreText(result.score, winScore), value);
+        if (moveValue(board, result.cell, mover) != value)
+            return disagree(failure, where, engine, "plays " + cellText(variant, result.cell), value);
+    }
+
+    const Tablebase &table = tablebase3x3();
+    if (table.isOpen()) {
+        int probed = TB_INVALID;
+        const int cell = table.bestMove(pos, &probed);
+        const int probedValue = probed == TB_WIN ? 1 : (probed == TB_LOSS ? -1 : (probed == TB_DRAW ? 0 : 2));
+        if (probedValue != value)
+            return disagree(failure, where, "Tablebase", "probes " + std::to_string(probed), value);
+        if (moveValue(board, cell, mover) != value)
+            return disagree(failure, where, "Tablebase", "plays " + cellText(variant, cell), value);
+
+        // A depth-1 search cannot prove most of these values, so this checks the probe.
+        config.depth = 1;
+        config.tablebase = &table;
+        const SearchResult result = searchMove(variant, pos, config);
+        config.depth = variant.cells;
+        config.tablebase = nullptr;
+        if (provenValue(result.score, winScore) != value)
+            return disagree(failure, where, "searchMove with tablebase", scoreText(result.score, winScore), value);
+        if (moveValue(board, result.cell, mover) != value)
+            return disagree(failure, where, "searchMove with tablebase", "plays " + cellText(variant, result.cell), value);
+    }
+
+    if (ttt_game_best_move(game.get(), 0, 0, &row, &col, &score) != TTT_OK ||
+        provenValue(score, winScore) != value)
+        return disagree(failure, where, "ttt_game_best_move", scoreText(score, winScore), value);
+    if (moveValue(board, row * 3 + col, mover) != value)
+        return disagree(failure, where, "ttt_game_best_move", "plays " + cellText(variant, row * 3 + col), value);
+    return true;
+}
+
+// Plain minimax for the side owning `mine`: 1 win, 0 draw, -1 loss.
+int exactValue(const Variant &variant, CellMask mine, CellMask theirs) {
+    if (hasLine(variant, theirs))
+        return -1;
+    CellMask empty = variant.full & ~(mine | theirs);
+    if (!empty)
+        return 0;
+    int best = -1;
+    while (empty && best < 1) {
+        const CellMask bit = empty & (~empty + 1);
+        empty &= empty - 1;
+        best = std::max(best, -exactValue(variant, theirs, mine | bit));
+    }
+    return best;
+}
+
+bool checkKInARow(ByteReader &in, std::string &failure) {
+    const int size = 3 + static_cast<int>(in.next() % 4);
+    const int k = 3 + static_cast<int>(in.next() % (size - 2));
+    const Variant &variant = fuzzVariant(size, k);
+    const int left = 1 + static_cast<int>(in.next() % kMaxReferenceEmpty);
+    Position pos = { 0, 0 };
+    while (!decided(variant, pos) && popCount(emptyCells(variant, pos)) > left) {
+        const CellMask empty = emptyCells(variant, pos);
+        const int cell = nthCell(empty, static_cast<int>(in.next() % popCount(empty)));
+        (sideToMove(pos) == 'X' ? pos.x : pos.o) |= cellBit(cell);
+    }
+
+    const std::string where = std::to_string(size) + "x" + std::to_string(size) + " k=" + std::to_string(k) +
+                              " " + positionText(variant, pos);
+    EngineConfig config = { "", variant.cells, 0, true, nullptr, 0, kProofTableBytes, nullptr };
+    if (decided(variant, pos)) {
+        if (searchMove(variant, pos, config).cell != -1) {
+            failure = where + ": searchMove found a move in a finished game";
+            return false;
+        }
+        return true;
+    }
+
+    const bool xToMove = sideToMove(pos) == 'X';
+    const CellMask mine = xToMove ? pos.x : pos.o;
+    const CellMask theirs = xToMove ? pos.o : pos.x;
+    const int value = exactValue(variant, mine, theirs);
+    const int winScore = kSearchWinScore - variant.cells;
+    const char *const engines[] = { "searchMove", "searchMove without alpha-beta", "searchMove with df-pn" };
+    for (int mode = 0; mode < 3; ++mode) {
+        config.alphaBeta = mode != 1;
+        config.proofNodes = mode == 2 ? kProofNodes : 0;
+        const SearchResult result = searchMove(variant, pos, config);
+        if (provenValue(result.score, winScore) != value)
+            return disagree(failure, where, engines[mode], scoreText(result.score, winScore), value);
+        const CellMask bit = result.cell >= 0 ? cellBit(result.cell) : 0;
+        if (!(emptyCells(variant, pos) & bit) || -exactValue(variant, theirs, mine | bit) != value)
+            return disagree(failure, where, engines[mode], "plays " + cellText(variant, result.cell), value);
+    }
+
+    // An unproven result is allowed, a wrong one is not.
+    thread_local ProofSolver prover(kProofTableBytes);
+    const ProofResult proof = prover.solve(variant, pos, kProofNodes);
+    const int proofValue = proof.value == PROOF_WIN ? 1 : (proof.value == PROOF_LOSS ? -1 : 0);
+    if (proof.value != PROOF_UNKNOWN && proofValue != value)
+        return disagree(failure, where, "ProofSolver", std::string("proves a ") + proofValueName(proof.value), value);
+    if (proof.value == PROOF_WIN) {
+        const CellMask bit = proof.cell >= 0 ? cellBit(proof.cell) : 0;
+        if (!(emptyCells(variant, pos) & bit) || -exactValue(variant, theirs, mine | bit) != 1)
+            return disagree(failure, where, "ProofSolver", "plays " + cellText(variant, proof.cell), value);
+    }
+    return true;
+}
+
+// Plain minimax over ultimate positions for the side to move. Returns false
+// once budget nodes are spent, so large trees are skipped, not searched.
+bool ultimateValue(const UltimatePosition &pos, uint64_t &budget, int &value) {
+    if (budget == 0)
+        return false;
+    --budget;
+    const char winner = ultimateWinner(pos);
+    if (winner != ' ') {
+        value = winner == 'D' ? 0 : (winner == pos.toMove ? 1 : -1);
+        return true;
+    }
+    uint8_t moves[81];
+    const int count = ultimateMoves(pos, moves);
+    value = -1;
+    for (int i = 0; i < count && value < 1; ++i) {
+        UltimatePosition next = pos;
+        ultimatePlay(next, moves[i]);
+        int child = 0;
+        if (!ultimateValue(next, budget, child))
+            return false;
+        value = std::max(value, -child);
+    }
+    return true;
+}
+
+bool checkUltimate(ByteReader &in, std::string &failure) {
+    const size_t back = 1 + in.next() % 10;
+    UltimatePosition pos;
+    ultimateReset(pos);
+    std::vector<UltimatePosition> line(1, pos);
+    std::vector<int> played;
+    uint8_t moves[81];
+    int count;
+    while ((count = ultimateMoves(pos, moves)) > 0) {
+        played.push_back(moves[in.next() % count]);
+        ultimatePlay(pos, played.back());
+        line.push_back(pos);
+    }
+    // A random game played to the end, then taken back a few plies.
+    const size_t ply = line.size() > back ? line.size() - 1 - back : 0;
+    const UltimatePosition &start = line[ply];
+    uint64_t budget = kUltimateReferenceNodes;
+    int value = 0;
+    if (!ultimateValue(start, budget, value))
+        return true;
+
+    std::string where = "ultimate after";
+    for (size_t i = 0; i < ply; ++i)
+        where += " " + std::to_string(ultimateRow(played[i])) + "-" + std::to_string(ultimateCol(played[i]));
+    where += std::string(" (") + start.toMove + " to move)";
+    const UltimateSearchResult result = ultimateSearch(start, 0, 81);
+    const int winScore = kUltimateWinScore - 81;
+    if (provenValue(result.score, winScore) != value)
+        return disagree(failure, where, "ultimateSearch", scoreText(result.score, winScore), value);
+    int child = 2;
+    if (result.move >= 0 && ultimateIsLegal(start, result.move)) {
+        UltimatePosition next = start;
+        ultimatePlay(next, result.move);
+        budget = kUltimateReferenceNodes;
+        ultimateValue(next, budget, child);
+        child = -child;
+    }
+    if (child != value)
+        return disagree(failure, where, "ultimateSearch", "plays move " + std::to_string(result.move), value);
+    return true;
+}
+
+// ------------------------------------------------------------------
+// Decoder targets
+
+bool sameRecord(const GameRecord &a, const GameRecord &b) {
+    if (a.mode != b.mode || a.winner != b.winner || a.moves.size() != b.moves.size())
+        return false;
+    for (size_t i = 0; i < a.moves.size(); ++i)
+        if (a.moves[i].row != b.moves[i].row || a.moves[i].col != b.moves[i].col || a.moves[i].player != b.moves[i].player)
+            return false;
+    return true;
+}
+
+bool sameGames(const std::vector<GameRecord> &a, const std::vector<GameRecord> &b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (!sameRecord(a[i], b[i]))
+            return false;
+    return true;
+}
+
+bool checkRecord(const std::string &line, std::string &failure) {
+    GameRecord record;
+    if (decodeGameRecord(line, record)) {
+        GameRecord again;
+        if (!decodeGameRecord(encodeGameRecord(record), again) || !sameRecord(record, again)) {
+            failure = "history line " + quoted(line) + " does not survive encode/decode";
+            return false;
+        }
+        std::vector<MoveEvaluation> evaluations;
+        if (analyseGame(record, evaluations) && evaluations.size() != record.moves.size()) {
+            failure = "analyseGame accepted " + quoted(line) + " but evaluated " +
+                      std::to_string(evaluations.size()) + " of " + std::to_string(record.moves.size()) + " moves";
+            return false;
+        }
+        for (const MoveEvaluation &evaluation : evaluations) {
+            if (evaluation.before < -1 || evaluation.before > 1 || evaluation.after > evaluation.before) {
+                failure = "analyseGame of " + quoted(line) + " gives a move that beats the best move";
+                return false;
+            }
+        }
+    }
+
+    // The C API reads up to the first NUL, like any C caller would pass it.
+    GamePtr game(ttt_game_new(3, 3));
+    const int loaded = ttt_game_load_record(game.get(), line.c_str());
+    if (loaded != TTT_OK) {
+        if ((loaded != TTT_ERROR_FORMAT && loaded != TTT_ERROR_ILLEGAL) || ttt_game_move_count(game.get()) != 0) {
+            failure = "ttt_game_load_record(" + quoted(line) + ") failed with " + std::to_string(loaded) +
+                      " and left " + std::to_string(ttt_game_move_count(game.get())) + " moves";
+            return false;
+        }
+        return true;
+    }
+    const int length = ttt_game_save_record(game.get(), "PvP", nullptr, nullptr, 0);
+    std::vector<char> saved(static_cast<size_t>(std::max(length, 0)) + 1);
+    GamePtr copy(ttt_game_new(3, 3));
+    bool same = length >= 0 && ttt_game_save_record(game.get(), "PvP", nullptr, saved.data(), saved.size()) == length &&
+                ttt_game_load_record(copy.get(), saved.data()) == TTT_OK &&
+                ttt_game_move_count(copy.get()) == ttt_game_move_count(game.get());
+    for (int cell = 0; same && cell < 9; ++cell)
+        same = ttt_game_cell(copy.get(), cell / 3, cell % 3) == ttt_game_cell(game.get(), cell / 3, cell % 3);
+    if (!same) {
+        failure = "ttt_game_load_record(" + quoted(line) + ") does not survive save/load";
+        return false;
+    }
+    return true;
+}
+
+bool checkAnalysis(const std::string &line, std::string &failure) {
+    uint64_t key = 0;
+    std::vector<MoveEvaluation> evaluations;
+    if (!decodeAnalysis(line, key, evaluations))
+        return true;
+    for (const MoveEvaluation &evaluation : evaluations) {
+        if (evaluation.before < -1 || evaluation.before > 1 || evaluation.after < -1 || evaluation.after > 1) {
+            failure = "decodeAnalysis(" + quoted(line) + ") returned a value outside -1..1";
+            return false;
+        }
+    }
+    // Every accepted line is one the encoder would write.
+    if (encodeAnalysis(key, evaluations) != line) {
+        failure = "analysis line " + quoted(line) + " does not survive decode/encode";
+        return false;
+    }
+    return true;
+}
+
+bool checkJournal(const uint8_t *data, size_t size, std::string &failure) {
+    const std::string path = scratch.path("journal.wal");
+    if (!writeFile(path, data, size))
+        return true;
+    Journal journal;
+    std::vector<std::string> records;
+    if (!journal.open(path, records) || journal.recordCount() != records.size()) {
+        failure = "Journal::open failed on an existing " + std::to_string(size) + " byte file";
+        return false;
+    }
+    journal.close();
+    // Opening cut off any damaged tail, so a second open must agree.
+    std::vector<std::string> again;
+    if (!journal.open(path, again) || again != records) {
+        failure = "Journal::open recovered " + std::to_string(records.size()) + " records, then " +
+                  std::to_string(again.size()) + " on reopening";
+        return false;
+    }
+    return true;
+}
+
+bool checkMoveTrie(const uint8_t *data, size_t size, std::string &failure) {
+    const std::string path = scratch.path("history.trie");
+    if (!writeFile(path, data, size))
+        return true;
+    // In trie mode the text history stops being written at migration, so it
+    // must never replace a trie file that exists, whether or not it loads.
+    GameRecord staleGame;
+    staleGame.mode = "PvP";
+    staleGame.winner = "Draw";
+    const std::vector<GameRecord> stale(1, staleGame);
+    MoveTrie trie;
+    bool missing = true;
+    const bool loaded = trie.load(path, &missing);
+    const std::vector<uint8_t> before = readFile(path); // after any torn-tail repair
+    MoveTrie migrated;
+    if (missing || migrated.migrate(path, stale) || readFile(path) != before) {
+        failure = "MoveTrie::migrate replaced an existing trie (" + std::to_string(size) +
+                  " bytes) with a stale history";
+        return false;
+    }
+    const std::string freshPath = scratch.path("fresh.trie");
+    std::remove(freshPath.c_str());
+    MoveTrie fresh;
+    if (fresh.load(freshPath, &missing) || !missing || !fresh.migrate(freshPath, stale) ||
+        !fresh.load(freshPath) || !sameGames(fresh.games(), stale)) {
+        failure = "MoveTrie did not migrate a history to a missing trie file";
+        return false;
+    }
+    if (!loaded)
+        return true;
+    const std::vector<GameRecord> games = trie.games();
+    for (size_t i = 0; i < games.size(); ++i) {
+        if (!sameRecord(trie.game(i), games[i])) {
+            failure = "MoveTrie::game(" + std::to_string(i) + ") differs from games()";
+            return false;
+        }
+    }
+    MoveTrie rebuilt;
+    MoveTrie reloaded;
+    const std::string copyPath = scratch.path("rebuilt.trie");
+    if (games.size() != trie.gameCount() || !rebuilt.rebuild(copyPath, games) || !reloaded.load(copyPath) ||
+        !sameGames(reloaded.games(), games)) {
+        failure = "MoveTrie loaded " + std::to_string(games.size()) + " games that do not survive rebuild/load";
+        return false;
+    }
+    return true;
+}
+
+bool checkPositionIndex(const uint8_t *data, size_t size, std::string &failure) {
+    const std::string path = scratch.path("positions.idx");
+    if (!writeFile(path, data, size))
+        return true;
+    PositionIndex index;
+    if (!index.load(path))
+        return true;
+    const BoardState board = emptyBoard();
+    for (const PositionOccurrence &occurrence : index.gamesReaching(board)) {
+        if (occurrence.game >= index.gameCount() || occurrence.ply != 0) {
+            failure = "PositionIndex lists game " + std::to_string(occurrence.game) + " at ply " +
+                      std::to_string(occurrence.ply) + " for the empty board but holds " +
+                      std::to_string(index.gameCount()) + " games";
+            return false;
+        }
+    }
+    const PositionStats stats = index.statsFrom(board);
+    if (stats.games < 0 || stats.xWins < 0 || stats.oWins < 0 || stats.draws < 0 ||
+        stats.xWins + stats.oWins + stats.draws > stats.games) {
+        failure = "PositionIndex statistics do not add up";
+        return false;
+    }
+    return true;
+}
+
+bool checkNetwork(const uint8_t *data, size_t size, std::string &failure) {
+    const std::string path = scratch.path("network.ttnn");
+    if (!writeFile(path, data, size))
+        return true;
+    NeuralNet net;
+    if (!net.load(path))
+        return true;
+    const NeuralWeights &weights = net.weights();
+    const Variant variant = makeVariant(weights.size, weights.k);
+    if (variant.cells == 0 || !net.matches(variant) || !net.isValid()) {
+        failure = "NeuralNet accepted a network for " + std::to_string(weights.size) + "x" +
+                  std::to_string(weights.size) + " k=" + std::to_string(weights.k);
+        return false;
+    }
+
+    // Accumulating stone by stone must match evaluating from scratch. Only
+    // meaningful for weights of trained magnitudes; with huge ones the
+    // summation order alone changes the result.
+    float largest = std::abs(weights.outputBias);
+    float outputSum = 0.0f;
+    for (const std::vector<float> *part : { &weights.input, &weights.inputBias, &weights.output })
+        for (float w : *part)
+            largest = std::max(largest, std::isfinite(w) ? std::abs(w) : INFINITY);
+    for (float w : weights.output)
+        outputSum += std::abs(w);
+    if (!(largest <= 100.0f))
+        return true;
+
+    std::vector<float> accumulator(static_cast<size_t>(2) * net.hidden());
+    Position pos = { 0, 0 };
+    std::vector<Position> line(1, pos); // every position on the way, as one batch
+    net.refresh(pos, accumulator.data());
+    for (int i = 0; i < 4 && i < variant.cells; ++i) {
+        const int cell = (i % 2) ? variant.cells - 1 - i / 2 : i / 2;
+        const char player = sideToMove(pos);
+        net.addStone(accumulator.data(), cell, player);
+        (player == 'X' ? pos.x : pos.o) |= cellBit(cell);
+        line.push_back(pos);
+    }
+    std::vector<float> batched(line.size());
+    net.evaluateBatch(line.data(), line.size(), batched.data());
+    const float tolerance = 1e-3f * (1.0f + outputSum);
+    for (size_t i = 0; i < line.size(); ++i) {
+        const float direct = net.evaluate(line[i]);
+        const float incremental = i + 1 == line.size() ? net.evaluate(accumulator.data(), sideToMove(pos)) : direct;
+        if (!(std::abs(incremental - direct) <= tolerance) || !(std::abs(batched[i] - direct) <= tolerance)) {
+            failure = "NeuralNet evaluates " + positionText(variant, line[i]) + " as " + std::to_string(direct) +
+                      " from scratch, " + std::to_string(incremental) + " incrementally and " +
+                      std::to_string(batched[i]) + " batched";
+            return false;
+        }
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------
+// Input generation
+
+GameRecord randomGame(std::mt19937_64 &rng) {
+    static const Variant variant = makeVariant(3, 3);
+    static const char *const kModes[] = { "PvP", "PvAI" };
+    GameRecord record;
+    record.mode = kModes[rng() % 2];
+    Position pos = { 0, 0 };
+    const size_t plies = rng() % 10;
+    while (record.moves.size() < plies && !decided(variant, pos)) {
+        const CellMask empty = emptyCells(variant, pos);
+        const int cell = nthCell(empty, static_cast<int>(rng() % popCount(empty)));
+        const char player = sideToMove(pos);
+        (player == 'X' ? pos.x : pos.o) |= cellBit(cell);
+        record.moves.push_back(Move{ cell / 3, cell % 3, player });
+    }
+    if (hasLine(variant, pos.x))
+        record.winner = "X";
+    else if (hasLine(variant, pos.o))
+        record.winner = record.mode == "PvAI" ? "AI" : "O";
+    else
+        record.winner = emptyCells(variant, pos) == 0 ? "Draw" : "";
+    return record;
+}
+
+GameRecord randomUltimateGame(std::mt19937_64 &rng) {
+    GameRecord record;
+    record.mode = kUltimateMode;
+    UltimatePosition pos;
+    ultimateReset(pos);
+    uint8_t moves[81];
+    int count;
+    while ((count = ultimateMoves(pos, moves)) > 0) {
+        const int move = moves[rng() % count];
+        record.moves.push_back(Move{ ultimateRow(move), ultimateCol(move), pos.toMove });
+        ultimatePlay(pos, move);
+    }
+    const char winner = ultimateWinner(pos);
+    record.winner = winner == 'D' ? "Draw" : std::string(1, winner);
+    return record;
+}
+
+std::vector<GameRecord> randomHistory(std::mt19937_64 &rng) {
+    std::vector<GameRecord> history(rng() % 6);
+    for (GameRecord &record : history)
+        record = (rng() % 8) ? randomGame(rng) : randomUltimateGame(rng);
+    return history;
+}
+
+std::vector<uint8_t> bytesOf(const std::string &text) {
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// A few byte-level edits; text targets also get separators and digits so
+// mutations reach the field parsers rather than just the first check.
+void mutate(std::vector<uint8_t> &bytes, bool text, std::mt19937_64 &rng) {
+    static const char kAlphabet[] = "|;-\tXOD0123456789LW";
+    const int edits = static_cast<int>(rng() % 5);
+    for (int i = 0; i < edits; ++i) {
+        const size_t at = bytes.empty() ? 0 : rng() % bytes.size();
+        const uint8_t value = text ? static_cast<uint8_t>(kAlphabet[rng() % (sizeof(kAlphabet) - 1)])
+                                   : static_cast<uint8_t>(rng());
+        switch (rng() % 6) {
+        case 0:
+            if (!bytes.empty())
+                bytes[at] ^= static_cast<uint8_t>(1u << (rng() % 8));
+            break;
+        case 1:
+            if (!bytes.empty())
+                bytes[at] = value;
+            break;
+        case 2:
+            bytes.insert(bytes.begin() + static_cast<std::ptrdiff_t>(at), value);
+            break;
+        case 3:
+            if (!bytes.empty())
+                bytes.erase(bytes.begin() + static_cast<std::ptrdiff_t>(at),
+                            bytes.begin() + static_cast<std::ptrdiff_t>(std::min(bytes.size(), at + 1 + rng() % 8)));
+            break;
+        case 4:
+            bytes.resize(at);
+            break;
+        default: {
+            const size_t length = std::min<size_t>(bytes.size() - at, 1 + rng() % 16);
+            const std::vector<uint8_t> chunk(bytes.begin() + static_cast<std::ptrdiff_t>(at),
+                                             bytes.begin() + static_cast<std::ptrdiff_t>(at + length));
+            bytes.insert(bytes.begin() + static_cast<std::ptrdiff_t>(rng() % (bytes.size() + 1)), chunk.begin(), chunk.end());
+            break;
+        }
+        }
+    }
+}
+
+} // namespace
+
+// ------------------------------------------------------------------
+// Fuzz Target Implementation
+
+const char *fuzzTargetName(int target) {
+    return target >= 0 && target < FUZZ_TARGET_COUNT ? kTargetNames[target] : "unknown";
+}
+
+int fuzzTargetByName(const std::string &name) {
+    for (int target = 0; target < FUZZ_TARGET_COUNT; ++target)
+        if (name == kTargetNames[target])
+            return target;
+    return -1;
+}
+
+bool runFuzzTarget(int target, const uint8_t *data, size_t size, std::string &failure) {
+    ByteReader in(data, size);
+    const std::string text(reinterpret_cast<const char*>(data), size);
+    switch (target) {
+    case FUZZ_MINIMAX:
+        return checkMinimax(in, failure);
+    case FUZZ_KINAROW:
+        return checkKInARow(in, failure);
+    case FUZZ_ULTIMATE:
+        return checkUltimate(in, failure);
+    case FUZZ_RECORD:
+        return checkRecord(text, failure);
+    case FUZZ_ANALYSIS:
+        return checkAnalysis(text, failure);
+    case FUZZ_JOURNAL:
+        return checkJournal(data, size, failure);
+    case FUZZ_MOVETRIE:
+        return checkMoveTrie(data, size, failure);
+    case FUZZ_POSITIONINDEX:
+        return checkPositionIndex(data, size, failure);
+    case FUZZ_NETWORK:
+        return checkNetwork(data, size, failure);
+    default:
+        return true;
+    }
+}
+
+std::vector<uint8_t> fuzzSeed(int target, std::mt19937_64 &rng) {
+    switch (target) {
+    case FUZZ_MINIMAX:
+    case FUZZ_KINAROW:
+    case FUZZ_ULTIMATE: {
+        std::vector<uint8_t> bytes(96);
+        for (uint8_t &byte : bytes)
+            byte = static_cast<uint8_t>(rng());
+        return bytes;
+    }
+    case FUZZ_RECORD:
+        return bytesOf(encodeGameRecord((rng() % 8) ? randomGame(rng) : randomUltimateGame(rng)));
+    case FUZZ_ANALYSIS: {
+        // Any values will do for the decoder; analyseGame would cost a search per move.
+        std::vector<MoveEvaluation> evaluations(rng() % 10);
+        for (MoveEvaluation &evaluation : evaluations) {
+            evaluation.before = static_cast<int>(rng() % 3) - 1;
+            evaluation.after = evaluation.before - static_cast<int>(rng() % (evaluation.before + 2));
+        }
+        return bytesOf(encodeAnalysis(gameRecordKey(randomGame(rng)), evaluations));
+    }
+    case FUZZ_JOURNAL: {
+        // Built in memory: Journal::append waits for the disk on every record.
+        std::vector<uint8_t> bytes;
+        for (int i = static_cast<int>(rng() % 4); i > 0; --i) {
+            const std::string payload = "G\tfuzz\t" + std::to_string(i) + "\t" + encodeGameRecord(randomGame(rng));
+            const uint32_t header[2] = { static_cast<uint32_t>(payload.size()), crc32(payload.data(), payload.size()) };
+            for (uint32_t field : header)
+                for (int shift = 0; shift < 32; shift += 8)
+                    bytes.push_back(static_cast<uint8_t>(field >> shift));
+            bytes.insert(bytes.end(), payload.begin(), payload.end());
+        }
+        return bytes;
+    }
+    case FUZZ_MOVETRIE: {
+        const std::string path = scratch.path("seed.trie");
+        MoveTrie trie;
+        trie.rebuild(path, randomHistory(rng));
+        return readFile(path);
+    }
+    case FUZZ_POSITIONINDEX: {
+        const std::string path = scratch.path("seed.idx");
+        PositionIndex index;
+        index.rebuild(path, randomHistory(rng));
+        return readFile(path);
+    }
+    case FUZZ_NETWORK: {
+        const std::string path = scratch.path("seed.ttnn");
+        const int size = 3 + static_cast<int>(rng() % 3);
+        NeuralNet net;
+        net.initialize(makeVariant(size, 3), 8, rng());
+        net.save(path);
+        return readFile(path);
+    }
+    default:
+        return std::vector<uint8_t>();
+    }
+}
+
+std::vector<uint8_t> generateFuzzInput(int target, std::mt19937_64 &rng) {
+    std::vector<uint8_t> bytes = fuzzSeed(target, rng);
+    if (target != FUZZ_MINIMAX && target != FUZZ_KINAROW && target != FUZZ_ULTIMATE)
+        mutate(bytes, target == FUZZ_RECORD || target == FUZZ_ANALYSIS, rng);
+    return bytes;
+}
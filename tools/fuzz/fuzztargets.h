@@ -0,0 +1,46 @@
+#ifndef FUZZTARGETS_H
+#define FUZZTARGETS_H
+
+// Differential and robustness checks of the game core, shared by the
+// libFuzzer entry point (fuzzentry.cpp) and the deterministic random mode
+// of tictactoe-fuzz (main.cpp). Every target takes an arbitrary byte
+// string. Engine targets turn it into a legal position and check that the
+// fast engines agree with the reference minimax; decoder targets feed it
+// to a parser as a line or a file and check that whatever is accepted
+// round-trips.
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+enum FuzzTarget {
+    FUZZ_MINIMAX,       // 3x3: MinimaxCache, evalBestMove, searchMove (also over a tablebase), tablebase, C API vs searchMinimax
+    FUZZ_KINAROW,       // endgames up to 6x6: searchMove (alpha-beta on/off, df-pn) and ProofSolver vs plain minimax
+    FUZZ_ULTIMATE,      // ultimate endgames: ultimateSearch vs plain minimax
+    FUZZ_RECORD,        // history lines: decodeGameRecord, analyseGame, ttt_game_load_record
+    FUZZ_ANALYSIS,      // analysis cache lines: decodeAnalysis
+    FUZZ_JOURNAL,       // journal files: Journal::open
+    FUZZ_MOVETRIE,      // trie history files: MoveTrie::load, and migrate leaving them intact
+    FUZZ_POSITIONINDEX, // position index files: PositionIndex::load
+    FUZZ_NETWORK,       // network files: NeuralNet::load
+    FUZZ_TARGET_COUNT
+};
+
+const char *fuzzTargetName(int target);
+// Returns -1 for an unknown name.
+int fuzzTargetByName(const std::string &name);
+
+// Runs one input. Returns false and describes the disagreement in failure
+// when a check fails; crashes and memory errors are left to the sanitizers.
+bool runFuzzTarget(int target, const uint8_t *data, size_t size, std::string &failure);
+
+// An input for target drawn from rng: random bytes for the engine targets,
+// a valid line or file with a few random mutations for the decoders.
+std::vector<uint8_t> generateFuzzInput(int target, std::mt19937_64 &rng);
+
+// Unmutated valid inputs, e.g. as a starting corpus for libFuzzer.
+std::vector<uint8_t> fuzzSeed(int target, std::mt19937_64 &rng);
+
+#endif // FUZZTARGETS_H
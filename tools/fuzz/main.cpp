@@ -0,0 +1,233 @@
+#include "fuzztargets.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <vector>
+
+// Failures kept per chunk and reported per target; the rest are only counted.
+static const size_t kReportedFailures = 8;
+static const uint64_t kChunkInputs = 64;
+
+// Inputs first .. first + count - 1 of one target. Input i is generated
+// from (seed, target, i) alone, so a run finds the same failures however
+// it is split across threads.
+struct FuzzChunk {
+    int target;
+    uint64_t seed;
+    uint64_t first;
+    uint64_t count;
+};
+
+struct FuzzFailure {
+    uint64_t index;
+    std::string message;
+    std::vector<uint8_t> input;
+};
+
+struct ChunkResult {
+    uint64_t failures;
+    std::vector<FuzzFailure> reported;
+};
+
+static std::mt19937_64 inputRng(uint64_t seed, int target, uint64_t index)
+{
+    std::seed_seq sequence{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), static_cast<uint32_t>(target),
+                            static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32) };
+    return std::mt19937_64(sequence);
+}
+
+static ChunkResult runChunk(const FuzzChunk &chunk)
+{
+    ChunkResult result = { 0, {} };
+    for (uint64_t index = chunk.first; index < chunk.first + chunk.count; ++index)
+    {
+        std::mt19937_64 rng = inputRng(chunk.seed, chunk.target, index);
+        const std::vector<uint8_t> input = generateFuzzInput(chunk.target, rng);
+        std::string failure;
+        if (runFuzzTarget(chunk.target, input.data(), input.size(), failure))
+            continue;
+        ++result.failures;
+        if (result.reported.size() < kReportedFailures)
+            result.reported.push_back(FuzzFailure{ index, failure, input });
+    }
+    return result;
+}
+
+// Files hold the target byte and then the input, as libFuzzer sees them.
+static bool writeInput(const QString &path, int target, const std::vector<uint8_t> &input)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    QByteArray bytes(1, static_cast<char>(target));
+    bytes.append(reinterpret_cast<const char*>(input.data()), static_cast<int>(input.size()));
+    return file.write(bytes) == bytes.size();
+}
+
+static int replayInputs(const QStringList &paths, QTextStream &out, QTextStream &err)
+{
+    int failed = 0;
+    for (const QString &path : paths)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            err << "Cannot read " << path << "\n";
+            return 1;
+        }
+        const QByteArray bytes = file.readAll();
+        if (bytes.isEmpty())
+            continue;
+        const int target = static_cast<uint8_t>(bytes[0]) % FUZZ_TARGET_COUNT;
+        std::string failure;
+        const bool ok = runFuzzTarget(target, reinterpret_cast<const uint8_t*>(bytes.constData()) + 1,
+                                      static_cast<size_t>(bytes.size() - 1), failure);
+        out << path << " (" << fuzzTargetName(target) << "): "
+            << (ok ? QString("ok") : QString::fromStdString(failure)) << "\n";
+        failed += ok ? 0 : 1;
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-fuzz");
+
+    QStringList names;
+    for (int target = 0; target < FUZZ_TARGET_COUNT; ++target)
+        names << fuzzTargetName(target);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Checks the fast engines against the reference minimax and the decoders "
+                                     "against malformed input, on deterministic random inputs.");
+    parser.addHelpOption();
+    QCommandLineOption targetOption("target", "Target to run (repeatable): " + names.join(", ") + ".", "name");
+    QCommandLineOption inputsOption("inputs", "Inputs per target.", "count", "20000");
+    QCommandLineOption threadsOption("threads", "Threads (0 = one per core).", "count", "0");
+    QCommandLineOption seedOption("seed", "Seed of the inputs.", "seed", "1");
+    QCommandLineOption failuresOption("failures-dir", "Directory for the inputs of failed checks.", "dir", ".");
+    QCommandLineOption corpusOption("write-corpus", "Write valid seed inputs for libFuzzer to dir and exit.", "dir");
+    QCommandLineOption replayOption("replay", "Run the saved input file and exit (repeatable).", "file");
+    parser.addOption(targetOption);
+    parser.addOption(inputsOption);
+    parser.addOption(threadsOption);
+    parser.addOption(seedOption);
+    parser.addOption(failuresOption);
+    parser.addOption(corpusOption);
+    parser.addOption(replayOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (parser.isSet(replayOption))
+        return replayInputs(parser.values(replayOption), out, err);
+
+    std::vector<int> targets;
+    for (const QString &name : parser.values(targetOption))
+    {
+        const int target = fuzzTargetByName(name.toStdString());
+        if (target < 0)
+        {
+            err << "Unknown target: " << name << " (expected one of " << names.join(", ") << ")\n";
+            return 1;
+        }
+        targets.push_back(target);
+    }
+    if (targets.empty())
+        for (int target = 0; target < FUZZ_TARGET_COUNT; ++target)
+            targets.push_back(target);
+    const uint64_t inputs = std::max(1ULL, parser.value(inputsOption).toULongLong());
+    const uint64_t seed = parser.value(seedOption).toULongLong();
+    int threads = parser.value(threadsOption).toInt();
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+
+    if (parser.isSet(corpusOption))
+    {
+        const QString dir = parser.value(corpusOption);
+        if (!QDir().mkpath(dir))
+        {
+            err << "Cannot create corpus directory: " << dir << "\n";
+            return 1;
+        }
+        const uint64_t perTarget = std::min<uint64_t>(inputs, 64);
+        for (int target : targets)
+        {
+            for (uint64_t index = 0; index < perTarget; ++index)
+            {
+                std::mt19937_64 rng = inputRng(seed, target, index);
+                const QString path = QString("%1/%2-%3").arg(dir, fuzzTargetName(target)).arg(index);
+                if (!writeInput(path, target, fuzzSeed(target, rng)))
+                {
+                    err << "Cannot write " << path << "\n";
+                    return 1;
+                }
+            }
+        }
+        out << "Wrote " << perTarget * targets.size() << " inputs to " << dir << "\n";
+        return 0;
+    }
+
+    out << "Fuzzing " << targets.size() << " targets, " << inputs << " inputs each, on " << threads
+        << " threads (seed " << seed << ")\n\n";
+    out << QString("target").leftJustified(16) << qSetFieldWidth(12) << "inputs" << "failures" << "seconds"
+        << "inputs/s" << qSetFieldWidth(0) << "\n";
+    out.flush();
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    const QString failuresDir = parser.value(failuresOption);
+    uint64_t totalInputs = 0;
+    uint64_t totalFailures = 0;
+    QElapsedTimer total;
+    total.start();
+    for (int target : targets)
+    {
+        std::vector<FuzzChunk> chunks;
+        for (uint64_t first = 0; first < inputs; first += kChunkInputs)
+            chunks.push_back(FuzzChunk{ target, seed, first, std::min(kChunkInputs, inputs - first) });
+
+        QElapsedTimer timer;
+        timer.start();
+        const QList<ChunkResult> results = QtConcurrent::mapped(chunks, runChunk).results();
+        const double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-9);
+
+        uint64_t failures = 0;
+        std::vector<FuzzFailure> failed;
+        for (const ChunkResult &result : results)
+        {
+            failures += result.failures;
+            for (const FuzzFailure &failure : result.reported)
+                if (failed.size() < kReportedFailures)
+                    failed.push_back(failure);
+        }
+        out << QString(fuzzTargetName(target)).leftJustified(16) << qSetFieldWidth(12) << inputs << failures
+            << QString::number(seconds, 'f', 2) << QString::number(inputs / seconds, 'f', 0)
+            << qSetFieldWidth(0) << "\n";
+        out.flush();
+
+        for (const FuzzFailure &failure : failed)
+        {
+            const QString path = QString("%1/%2-failure-%3").arg(failuresDir, fuzzTargetName(target)).arg(failure.index);
+            err << fuzzTargetName(target) << " input " << failure.index << ": "
+                << QString::fromStdString(failure.message) << "\n";
+            if (writeInput(path, target, failure.input))
+                err << "  saved as " << path << " (run it again with --replay)\n";
+        }
+        err.flush();
+        totalInputs += inputs;
+        totalFailures += failures;
+    }
+
+    const double seconds = std::max(total.nsecsElapsed() / 1e9, 1e-9);
+    out << "\n" << totalInputs << " inputs in " << QString::number(seconds, 'f', 2) << " s ("
+        << QString::number(totalInputs / seconds, 'f', 0) << " inputs/s), " << totalFailures << " failures\n";
+    return totalFailures > 0 ? 1 : 0;
+}
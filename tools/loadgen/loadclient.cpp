@@ -0,0 +1,108 @@
+#include "loadclient.h"
+
+#include <QRandomGenerator>
+#include <QDebug>
+
+LoadClient::LoadClient(int gamesToPlay, std::vector<qint64> *latencies, QObject *parent)
+    : QObject(parent), latencies(latencies), board(emptyBoard()),
+      gamesToPlay(gamesToPlay), gamesDone(0), done(false)
+{
+    socket = new QTcpSocket(this);
+    connect(socket, &QTcpSocket::connected, this, &LoadClient::onConnected);
+    connect(socket, &QTcpSocket::readyRead, this, &LoadClient::onReadyRead);
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
+            this, &LoadClient::onError);
+}
+
+void LoadClient::start(const QString &host, quint16 port)
+{
+    socket->connectToHost(host, port);
+}
+
+int LoadClient::gamesPlayed() const
+{
+    return gamesDone;
+}
+
+void LoadClient::onConnected()
+{
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    send("NEW PVAI");
+}
+
+void LoadClient::onReadyRead()
+{
+    while (socket->canReadLine())
+        handleReply(QString::fromLatin1(socket->readLine()).trimmed());
+}
+
+void LoadClient::onError(QAbstractSocket::SocketError)
+{
+    if (done)
+        return;
+    qWarning() << "Connection error:" << socket->errorString();
+    done = true;
+    emit finished(false);
+}
+
+void LoadClient::handleReply(const QString &line)
+{
+    QStringList parts = line.split(' ');
+    if (parts.isEmpty() || done)
+        return;
+
+    if (parts[0] == "OK")
+    {
+        board = emptyBoard();
+        playRandomMove();
+    }
+    else if (parts[0] == "MOVED" && parts.size() == 4)
+    {
+        int row = parts[1].toInt();
+        int col = parts[2].toInt();
+        char player = parts[3].at(0).toLatin1();
+        board[row][col] = player;
+        if (player == 'O')
+        {
+            latencies->push_back(moveTimer.nsecsElapsed() / 1000);
+            playRandomMove();
+        }
+    }
+    else if (parts[0] == "OVER")
+    {
+        if (++gamesDone >= gamesToPlay)
+        {
+            done = true;
+            send("QUIT");
+            emit finished(true);
+        }
+        else
+            send("NEW PVAI");
+    }
+    else if (parts[0] == "ERR")
+    {
+        qWarning() << "Server error:" << line;
+        done = true;
+        emit finished(false);
+    }
+}
+
+void LoadClient::playRandomMove()
+{
+    // The game is over if the AI just won or filled the board; wait for OVER.
+    if (evalIsWinner(board, 'O') || evalIsFull(board))
+        return;
+    std::vector<Move> freeCells;
+    for (int row = 0; row < 3; ++row)
+        for (int col = 0; col < 3; ++col)
+            if (board[row][col] == ' ')
+                freeCells.push_back(Move{ row, col, 'X' });
+    const Move &m = freeCells[QRandomGenerator::global()->bounded(static_cast<int>(freeCells.size()))];
+    moveTimer.start();
+    send(QString("MOVE %1 %2").arg(m.row).arg(m.col));
+}
+
+void LoadClient::send(const QString &line)
+{
+    socket->write(line.toLatin1() + '\n');
+}
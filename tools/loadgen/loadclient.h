@@ -0,0 +1,46 @@
+#ifndef LOADCLIENT_H
+#define LOADCLIENT_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <vector>
+
+#include "gamecore.h"
+
+// --- LoadClient Class Definition ---
+// Plays a fixed number of PvAI games against the server with random legal
+// moves and records how long each AI reply takes to arrive.
+class LoadClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    LoadClient(int gamesToPlay, std::vector<qint64> *latencies, QObject *parent = nullptr);
+
+    void start(const QString &host, quint16 port);
+    int gamesPlayed() const;
+
+signals:
+    void finished(bool ok);
+
+private slots:
+    void onConnected();
+    void onReadyRead();
+    void onError(QAbstractSocket::SocketError error);
+
+private:
+    void handleReply(const QString &line);
+    void playRandomMove();
+    void send(const QString &line);
+
+    QTcpSocket *socket;
+    std::vector<qint64> *latencies; // microseconds from our move to the AI reply
+    QElapsedTimer moveTimer;
+    BoardState board;
+    int gamesToPlay;
+    int gamesDone;
+    bool done;
+};
+
+#endif // LOADCLIENT_H
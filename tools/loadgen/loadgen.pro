@@ -0,0 +1,15 @@
+QT = core network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-loadgen
+
+SOURCES += \
+    main.cpp \
+    loadclient.cpp
+
+HEADERS += \
+    loadclient.h
+
+include(../../core/core.pri)
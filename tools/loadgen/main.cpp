@@ -0,0 +1,68 @@
+#include "loadclient.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+
+// Returns the given percentile (0-100) of an ascending sample list.
+static qint64 percentile(const std::vector<qint64> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-loadgen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load generator for tictactoe-server: plays many PvAI games at once "
+                                     "and reports AI move latency.");
+    parser.addHelpOption();
+    QCommandLineOption hostOption("host", "Server address.", "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "Server port.", "port", "5555");
+    QCommandLineOption connectionsOption("connections", "Concurrent connections.", "count", "100");
+    QCommandLineOption gamesOption("games", "Games played per connection.", "count", "10");
+    parser.addOption(hostOption);
+    parser.addOption(portOption);
+    parser.addOption(connectionsOption);
+    parser.addOption(gamesOption);
+    parser.process(app);
+
+    const int connections = std::max(1, parser.value(connectionsOption).toInt());
+    const int games = std::max(1, parser.value(gamesOption).toInt());
+
+    std::vector<qint64> latencies;
+    int running = connections;
+    int failed = 0;
+    QElapsedTimer wallClock;
+    wallClock.start();
+
+    for (int i = 0; i < connections; ++i)
+    {
+        LoadClient *client = new LoadClient(games, &latencies, &app);
+        QObject::connect(client, &LoadClient::finished, &app, [&](bool ok) {
+            if (!ok)
+                ++failed;
+            if (--running == 0)
+                app.quit();
+        });
+        client->start(parser.value(hostOption), parser.value(portOption).toUShort());
+    }
+    app.exec();
+
+    const double seconds = wallClock.nsecsElapsed() / 1e9;
+    std::sort(latencies.begin(), latencies.end());
+    QTextStream out(stdout);
+    out << "connections:     " << connections << " (" << failed << " failed)\n";
+    out << "AI moves:        " << latencies.size() << " in " << QString::number(seconds, 'f', 2) << " s ("
+        << QString::number(latencies.size() / seconds, 'f', 0) << " moves/s)\n";
+    out << "move latency p50: " << QString::number(percentile(latencies, 50) / 1000.0, 'f', 3) << " ms\n";
+    out << "move latency p99: " << QString::number(percentile(latencies, 99) / 1000.0, 'f', 3) << " ms\n";
+    return failed == 0 ? 0 : 1;
+}
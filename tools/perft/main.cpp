@@ -0,0 +1,134 @@
+#include "perft.h"
+#include "allocstats.h"
+#include "gamecore.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+
+// Standard 3x3 counts from the empty board, ply 1..9.
+static const PerftCounts kReference3x3[9] = {
+    { 9, 0, 0, 0 },
+    { 72, 0, 0, 0 },
+    { 504, 0, 0, 0 },
+    { 3024, 0, 0, 0 },
+    { 15120, 1440, 0, 0 },
+    { 54720, 0, 5328, 0 },
+    { 148176, 47952, 0, 0 },
+    { 200448, 0, 72576, 0 },
+    { 127872, 81792, 0, 46080 },
+};
+
+static bool sameCounts(const PerftCounts &a, const PerftCounts &b)
+{
+    return a.nodes == b.nodes && a.xWins == b.xWins && a.oWins == b.oWins && a.draws == b.draws;
+}
+
+static uint64_t totalNodes(const std::vector<PerftCounts> &counts)
+{
+    uint64_t nodes = 0;
+    for (const PerftCounts &c : counts)
+        nodes += c.nodes;
+    return nodes;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-perft");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Enumerates the game tree and counts nodes and results per ply.");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size", "Board size (size x size).", "n", "3");
+    QCommandLineOption kOption("k", "Stones in a row needed to win.", "k", "3");
+    QCommandLineOption depthOption("depth", "Plies to enumerate (0 = until the board is full).", "plies", "0");
+    QCommandLineOption threadsOption("threads", "Threads for the parallel run (0 = one per core).", "count", "0");
+    QCommandLineOption positionOption("position", "Start position, row-major from X, O and '.'.", "board");
+    parser.addOption(sizeOption);
+    parser.addOption(kOption);
+    parser.addOption(depthOption);
+    parser.addOption(threadsOption);
+    parser.addOption(positionOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    Variant variant = makeVariant(parser.value(sizeOption).toInt(), parser.value(kOption).toInt());
+    if (variant.cells == 0)
+    {
+        err << "Invalid board size or k.\n";
+        return 1;
+    }
+    Position start = { 0, 0 };
+    if (parser.isSet(positionOption) && !parsePosition(variant, parser.value(positionOption).toStdString(), start))
+    {
+        err << "Invalid position: expected " << variant.cells << " cells of X, O or '.'.\n";
+        return 1;
+    }
+    const int empty = popCount(emptyCells(variant, start));
+    int depth = parser.value(depthOption).toInt();
+    if (depth <= 0 || depth > empty)
+        depth = empty;
+    int threads = parser.value(threadsOption).toInt();
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+
+    out << variant.size << "x" << variant.size << " k=" << variant.k << ", depth " << depth << "\n";
+    out.flush();
+
+    QElapsedTimer timer;
+    timer.start();
+    const std::vector<PerftCounts> serial = perft(variant, start, depth);
+    const double serialSeconds = timer.nsecsElapsed() / 1e9;
+    timer.restart();
+    const std::vector<PerftCounts> parallel = perftParallel(variant, start, depth, threads);
+    const double parallelSeconds = timer.nsecsElapsed() / 1e9;
+
+    const bool checkReference = variant.size == 3 && variant.k == 3 && start.x == 0 && start.o == 0;
+    bool ok = true;
+    PerftCounts total = { 0, 0, 0, 0 };
+    out << qSetFieldWidth(5) << "ply" << qSetFieldWidth(14) << "nodes" << "X wins" << "O wins" << "draws"
+        << qSetFieldWidth(0) << "\n";
+    for (int ply = 0; ply < depth; ++ply)
+    {
+        const PerftCounts &c = serial[ply];
+        bool match = sameCounts(c, parallel[ply]);
+        if (checkReference)
+            match = match && sameCounts(c, kReference3x3[ply]);
+        ok = ok && match;
+        total.xWins += c.xWins;
+        total.oWins += c.oWins;
+        total.draws += c.draws;
+        out << qSetFieldWidth(5) << ply + 1 << qSetFieldWidth(14) << c.nodes << c.xWins << c.oWins << c.draws
+            << qSetFieldWidth(0) << (match ? "" : "  MISMATCH") << "\n";
+    }
+
+    const uint64_t nodes = totalNodes(serial);
+    out << "finished games: " << total.xWins + total.oWins + total.draws << " (X " << total.xWins
+        << ", O " << total.oWins << ", draws " << total.draws << ")\n";
+    out << "1 thread:   " << QString::number(serialSeconds, 'f', 3) << " s, "
+        << QString::number(nodes / std::max(serialSeconds, 1e-9) / 1e6, 'f', 1) << " M nodes/s\n";
+    out << threads << " threads: " << QString::number(parallelSeconds, 'f', 3) << " s, "
+        << QString::number(nodes / std::max(parallelSeconds, 1e-9) / 1e6, 'f', 1) << " M nodes/s\n";
+    if (checkReference)
+        out << (ok ? "reference counts: match\n" : "reference counts: MISMATCH\n");
+    else if (!ok)
+        out << "serial and parallel counts differ\n";
+
+    // The AI search must stay off the heap; only measurable in tracking builds.
+    if (allocationTrackingEnabled())
+    {
+        const BoardState board = emptyBoard();
+        int row = -1, col = -1;
+        AllocationScope scope;
+        evalBestMove(board, row, col);
+        const uint64_t allocations = scope.allocations();
+        out << "AI search allocations: " << allocations << "\n";
+        ok = ok && allocations == 0;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-perft
+
+SOURCES += \
+    main.cpp
+
+include(../../core/core.pri)
@@ -0,0 +1,173 @@
+#include "gifwriter.h"
+
+#include <algorithm>
+
+// ------------------------------------------------------------------
+// GifWriter Implementation
+
+GifWriter::GifWriter()
+    : colorBits(1), colors(2), codeSize(2), bitBuffer(0), bitCount(0)
+{
+}
+
+void GifWriter::begin(int width, int height, const std::vector<uint32_t> &palette, int loops)
+{
+    out.clear();
+    // GIF color tables have 2^n entries with n >= 1; LZW codes start at n + 1 bits.
+    colorBits = 1;
+    while ((1 << colorBits) < static_cast<int>(palette.size()) && colorBits < 8)
+        ++colorBits;
+    colors = 1 << colorBits;
+    table.assign(4096 * colors, 0);
+
+    const char header[] = "GIF89a";
+    out.insert(out.end(), header, header + 6);
+    putWord(width);
+    putWord(height);
+    putByte(static_cast<uint8_t>(0x80 | ((colorBits - 1) << 4) | (colorBits - 1))); // global table
+    putByte(0); // background color
+    putByte(0); // square pixels
+    for (int i = 0; i < colors; ++i)
+    {
+        const uint32_t rgb = i < static_cast<int>(palette.size()) ? palette[i] : 0;
+        putByte(static_cast<uint8_t>(rgb >> 16));
+        putByte(static_cast<uint8_t>(rgb >> 8));
+        putByte(static_cast<uint8_t>(rgb));
+    }
+
+    // NETSCAPE2.0 application extension: loop count.
+    const char netscape[] = "NETSCAPE2.0";
+    putByte(0x21);
+    putByte(0xFF);
+    putByte(11);
+    out.insert(out.end(), netscape, netscape + 11);
+    putByte(3);
+    putByte(1);
+    putWord(loops);
+    putByte(0);
+}
+
+void GifWriter::addFrame(const uint8_t *indices, int stride, int x, int y, int w, int h, int delay)
+{
+    // Graphic control extension: keep the previous frame under this one.
+    putByte(0x21);
+    putByte(0xF9);
+    putByte(4);
+    putByte(1 << 2);
+    putWord(delay);
+    putByte(0);
+    putByte(0);
+
+    putByte(0x2C);
+    putWord(x);
+    putWord(y);
+    putWord(w);
+    putWord(h);
+    putByte(0); // no local color table, not interlaced
+
+    const int minCodeSize = std::max(colorBits, 2);
+    const int clearCode = 1 << minCodeSize;
+    putByte(static_cast<uint8_t>(minCodeSize));
+    block.clear();
+    bitBuffer = 0;
+    bitCount = 0;
+    codeSize = minCodeSize + 1;
+    resetTable();
+    putCode(clearCode);
+
+    int maxCode = clearCode + 1;
+    int current = -1;
+    for (int row = 0; row < h; ++row)
+    {
+        const uint8_t *pixel = indices + (y + row) * stride + x;
+        for (int col = 0; col < w; ++col)
+        {
+            const int value = pixel[col] & (colors - 1);
+            if (current < 0)
+            {
+                current = value;
+                continue;
+            }
+            uint16_t &next = table[current * colors + value];
+            if (next)
+            {
+                current = next;
+                continue;
+            }
+            putCode(current);
+            next = static_cast<uint16_t>(++maxCode);
+            if (maxCode >= (1 << codeSize))
+                ++codeSize;
+            if (maxCode == 4095)
+            {
+                // Dictionary full: start over.
+                putCode(clearCode);
+                resetTable();
+                codeSize = minCodeSize + 1;
+                maxCode = clearCode + 1;
+            }
+            current = value;
+        }
+    }
+    if (current >= 0)
+        putCode(current);
+    putCode(clearCode);
+    codeSize = minCodeSize + 1;
+    putCode(clearCode + 1); // end of information
+    flushBits();
+    flushBlock();
+    putByte(0); // block terminator
+}
+
+const std::vector<uint8_t> &GifWriter::finish()
+{
+    putByte(0x3B);
+    return out;
+}
+
+void GifWriter::putByte(uint8_t value)
+{
+    out.push_back(value);
+}
+
+void GifWriter::putWord(int value)
+{
+    putByte(static_cast<uint8_t>(value & 0xFF));
+    putByte(static_cast<uint8_t>((value >> 8) & 0xFF));
+}
+
+void GifWriter::putCode(int code)
+{
+    bitBuffer |= static_cast<uint32_t>(code) << bitCount;
+    bitCount += codeSize;
+    while (bitCount >= 8)
+    {
+        block.push_back(static_cast<uint8_t>(bitBuffer & 0xFF));
+        bitBuffer >>= 8;
+        bitCount -= 8;
+        if (block.size() == 255)
+            flushBlock();
+    }
+}
+
+void GifWriter::flushBits()
+{
+    if (bitCount > 0)
+        block.push_back(static_cast<uint8_t>(bitBuffer & 0xFF));
+    bitBuffer = 0;
+    bitCount = 0;
+}
+
+void GifWriter::flushBlock()
+{
+    if (block.empty())
+        return;
+    putByte(static_cast<uint8_t>(block.size()));
+    out.insert(out.end(), block.begin(), block.end());
+    block.clear();
+}
+
+void GifWriter::resetTable()
+{
+    std::fill(table.begin(), table.end(), 0);
+}
@@ -0,0 +1,43 @@
+#ifndef GIFWRITER_H
+#define GIFWRITER_H
+
+#include <cstdint>
+#include <vector>
+
+// --- GifWriter Class Definition ---
+// Minimal animated GIF89a encoder for palette images. Each frame may cover
+// only the rectangle that changed since the previous one; earlier frames
+// stay visible underneath. All buffers are kept between animations, so one
+// writer per thread encodes any number of games without reallocating.
+class GifWriter
+{
+public:
+    GifWriter();
+
+    // palette holds 0xRRGGBB entries (at most 256). loops = 0 repeats forever.
+    void begin(int width, int height, const std::vector<uint32_t> &palette, int loops = 0);
+    // Encodes the w x h rectangle at (x, y) of an index image with the given
+    // row stride, shown for delay hundredths of a second.
+    void addFrame(const uint8_t *indices, int stride, int x, int y, int w, int h, int delay);
+    // Terminates the stream and returns the complete file contents.
+    const std::vector<uint8_t> &finish();
+
+private:
+    void putByte(uint8_t value);
+    void putWord(int value);
+    void putCode(int code);
+    void flushBits();
+    void flushBlock();
+    void resetTable();
+
+    std::vector<uint8_t> out;
+    std::vector<uint16_t> table; // LZW dictionary: table[code * colors + pixel] = next code
+    std::vector<uint8_t> block;  // current data sub-block (up to 255 bytes)
+    int colorBits;
+    int colors;
+    int codeSize;
+    uint32_t bitBuffer;
+    int bitCount;
+};
+
+#endif // GIFWRITER_H
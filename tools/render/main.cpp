@@ -0,0 +1,193 @@
+#include "gamecore.h"
+#include "gifwriter.h"
+#include "replayrenderer.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+// Shared by the render workers; each claims games through nextGame.
+struct RenderJob {
+    std::vector<GameRecord> games;
+    QString outputDir;
+    bool gif;
+    int cellSize;
+    int delay; // hundredths of a second per move
+    std::atomic<size_t> nextGame;
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> bytes;
+    std::atomic<int> failures;
+};
+
+static bool writeFile(const QString &path, const char *data, qint64 size)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data, size) == size;
+}
+
+static QString gameName(size_t index)
+{
+    return QString("game-%1").arg(index + 1, 5, 10, QChar('0'));
+}
+
+// One worker: a renderer and a GIF writer whose buffers are reused for
+// every game the worker takes.
+static void renderGames(RenderJob *job)
+{
+    ReplayRenderer renderer(job->cellSize);
+    GifWriter gif;
+    const std::vector<uint32_t> palette = ReplayRenderer::palette();
+    const int size = 3 * job->cellSize;
+
+    for (size_t index = job->nextGame++; index < job->games.size(); index = job->nextGame++)
+    {
+        const GameRecord &record = job->games[index];
+        renderer.reset();
+        bool ok = true;
+        uint64_t frames = 1;
+
+        if (job->gif)
+        {
+            gif.begin(size, size, palette);
+            gif.addFrame(renderer.indices(), renderer.stride(), 0, 0, size, size, job->delay);
+            for (size_t i = 0; i < record.moves.size(); ++i)
+            {
+                const QRect changed = renderer.playMove(record.moves[i]);
+                if (changed.isEmpty())
+                    continue;
+                // Hold the final position three times as long.
+                const int delay = (i + 1 == record.moves.size()) ? 3 * job->delay : job->delay;
+                gif.addFrame(renderer.indices(), renderer.stride(), changed.x(), changed.y(),
+                             changed.width(), changed.height(), delay);
+                ++frames;
+            }
+            const std::vector<uint8_t> &data = gif.finish();
+            ok = writeFile(job->outputDir + "/" + gameName(index) + ".gif",
+                           reinterpret_cast<const char*>(data.data()), static_cast<qint64>(data.size()));
+            job->bytes += data.size();
+        }
+        else
+        {
+            const QString dir = job->outputDir + "/" + gameName(index);
+            ok = QDir().mkpath(dir) && renderer.frame().save(dir + "/frame-00.png", "PNG");
+            for (const Move &m : record.moves)
+            {
+                if (!ok || renderer.playMove(m).isEmpty())
+                    continue;
+                ok = renderer.frame().save(QString("%1/frame-%2.png").arg(dir).arg(frames, 2, 10, QChar('0')), "PNG");
+                ++frames;
+            }
+        }
+
+        job->frames += frames;
+        if (!ok)
+            job->failures++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-render");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders stored games to animated GIFs or PNG frame sequences.");
+    parser.addHelpOption();
+    QCommandLineOption historyOption("history", "History file (<user>_history.txt) to render.", "file");
+    QCommandLineOption outputOption("output", "Directory for the rendered replays.", "dir", "replays");
+    QCommandLineOption formatOption("format", "gif (one animation per game) or png (one file per frame).", "format", "gif");
+    QCommandLineOption cellOption("cell", "Cell size in pixels.", "pixels", "80");
+    QCommandLineOption delayOption("delay", "Time per move in milliseconds (GIF only).", "ms", "500");
+    QCommandLineOption threadsOption("threads", "Render threads (0 = one per core).", "count", "0");
+    QCommandLineOption limitOption("limit", "Render at most this many games (0 = all).", "count", "0");
+    parser.addOption(historyOption);
+    parser.addOption(outputOption);
+    parser.addOption(formatOption);
+    parser.addOption(cellOption);
+    parser.addOption(delayOption);
+    parser.addOption(threadsOption);
+    parser.addOption(limitOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    const QString format = parser.value(formatOption).toLower();
+    if (format != "gif" && format != "png")
+    {
+        err << "Unknown format: " << format << "\n";
+        return 1;
+    }
+
+    RenderJob job;
+    job.outputDir = parser.value(outputOption);
+    job.gif = format == "gif";
+    job.cellSize = std::min(std::max(parser.value(cellOption).toInt(), 8), 512);
+    job.delay = std::max(parser.value(delayOption).toInt() / 10, 1);
+    job.nextGame = 0;
+    job.frames = 0;
+    job.bytes = 0;
+    job.failures = 0;
+
+    QFile history(parser.value(historyOption));
+    if (!history.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        err << "Cannot open history file: " << history.fileName() << "\n";
+        return 1;
+    }
+    const int limit = parser.value(limitOption).toInt();
+    QTextStream in(&history);
+    while (!in.atEnd() && (limit <= 0 || static_cast<int>(job.games.size()) < limit))
+    {
+        GameRecord record;
+        // Ultimate games are 9x9; the renderer draws 3x3 boards only.
+        if (decodeGameRecord(in.readLine().toStdString(), record) && !isUltimateRecord(record))
+            job.games.push_back(record);
+    }
+    history.close();
+    if (!QDir().mkpath(job.outputDir))
+    {
+        err << "Cannot create output directory: " << job.outputDir << "\n";
+        return 1;
+    }
+
+    int threads = parser.value(threadsOption).toInt();
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(job.games.size())));
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    out << "Rendering " << job.games.size() << " games as " << format << " on " << threads << " threads...\n";
+    out.flush();
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<QFuture<void>> workers;
+    for (int t = 0; t < threads; ++t)
+        workers.push_back(QtConcurrent::run(&pool, renderGames, &job));
+    for (QFuture<void> &worker : workers)
+        worker.waitForFinished();
+    const double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-9);
+
+    const uint64_t frames = job.frames.load();
+    out << "frames:     " << frames << "\n";
+    out << "time:       " << QString::number(seconds, 'f', 2) << " s\n";
+    out << "throughput: " << QString::number(frames / seconds, 'f', 0) << " frames/s, "
+        << QString::number(job.games.size() / seconds, 'f', 0) << " games/s\n";
+    if (job.gif)
+        out << "written:    " << QString::number(job.bytes.load() / 1048576.0, 'f', 1) << " MB\n";
+    if (job.failures > 0)
+    {
+        err << job.failures.load() << " games could not be written.\n";
+        return 1;
+    }
+    return 0;
+}
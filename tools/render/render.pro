@@ -0,0 +1,17 @@
+QT = core gui concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-render
+
+SOURCES += \
+    main.cpp \
+    replayrenderer.cpp \
+    gifwriter.cpp
+
+HEADERS += \
+    replayrenderer.h \
+    gifwriter.h
+
+include(../../core/core.pri)
@@ -0,0 +1,113 @@
+#include "replayrenderer.h"
+
+#include <QPainter>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+enum PaletteIndex {
+    kBackground = 0, // empty cell, #f0f0f0 as in ReplayDialog
+    kBorder = 1,
+    kXFill = 2,
+    kOFill = 3,
+    kInk = 4
+};
+
+const uint32_t kPalette[] = { 0xF0F0F0, 0xCCCCCC, 0x87CEFA, 0xFFA07A, 0x333333 };
+
+uint8_t paletteIndex(QRgb pixel) {
+    const uint32_t rgb = pixel & 0xFFFFFF;
+    for (uint8_t i = 0; i < sizeof(kPalette) / sizeof(kPalette[0]); ++i)
+        if (kPalette[i] == rgb)
+            return i;
+    return kBackground;
+}
+
+QColor paletteColor(int index) {
+    return QColor(QRgb(kPalette[index]));
+}
+
+} // namespace
+
+// ------------------------------------------------------------------
+// ReplayRenderer Implementation
+
+ReplayRenderer::ReplayRenderer(int cellSize)
+    : cellSize(cellSize),
+      image(3 * cellSize, 3 * cellSize, QImage::Format_RGB32),
+      indexBuffer(static_cast<size_t>(9) * cellSize * cellSize),
+      board(emptyBoard())
+{
+}
+
+std::vector<uint32_t> ReplayRenderer::palette()
+{
+    return std::vector<uint32_t>(std::begin(kPalette), std::end(kPalette));
+}
+
+void ReplayRenderer::reset()
+{
+    for (int row = 0; row < 3; ++row)
+        for (int col = 0; col < 3; ++col)
+            paintCell(row, col, ' ');
+}
+
+QRect ReplayRenderer::playMove(const Move &m)
+{
+    if (m.row < 0 || m.row >= 3 || m.col < 0 || m.col >= 3 || board[m.row][m.col] != ' ')
+        return QRect();
+    paintCell(m.row, m.col, m.player);
+    return QRect(m.col * cellSize, m.row * cellSize, cellSize, cellSize);
+}
+
+const QImage &ReplayRenderer::frame() const
+{
+    return image;
+}
+
+const uint8_t *ReplayRenderer::indices() const
+{
+    return indexBuffer.data();
+}
+
+int ReplayRenderer::stride() const
+{
+    return image.width();
+}
+
+void ReplayRenderer::paintCell(int row, int col, char player)
+{
+    board[row][col] = player;
+    const QRect cell(col * cellSize, row * cellSize, cellSize, cellSize);
+    {
+        QPainter painter(&image);
+        const int fill = (player == 'X') ? kXFill : (player == 'O') ? kOFill : kBackground;
+        painter.fillRect(cell, paletteColor(fill));
+        painter.setPen(paletteColor(kBorder));
+        painter.drawRect(cell.adjusted(0, 0, -1, -1));
+
+        const int margin = cellSize / 4;
+        const QRect glyph = cell.adjusted(margin, margin, -margin, -margin);
+        painter.setPen(QPen(paletteColor(kInk), std::max(2, cellSize / 16)));
+        if (player == 'X')
+        {
+            painter.drawLine(glyph.topLeft(), glyph.bottomRight());
+            painter.drawLine(glyph.topRight(), glyph.bottomLeft());
+        }
+        else if (player == 'O')
+        {
+            painter.drawEllipse(glyph);
+        }
+    }
+
+    // Keep the index image in step, for the repainted cell only.
+    const int width = image.width();
+    for (int y = cell.top(); y <= cell.bottom(); ++y)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        uint8_t *out = indexBuffer.data() + static_cast<size_t>(y) * width;
+        for (int x = cell.left(); x <= cell.right(); ++x)
+            out[x] = paletteIndex(line[x]);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef REPLAYRENDERER_H
+#define REPLAYRENDERER_H
+
+#include <QImage>
+#include <QRect>
+#include <cstdint>
+#include <vector>
+
+#include "gamecore.h"
+
+// --- ReplayRenderer Class Definition ---
+// Draws a replay board offscreen with QPainter, in the colours of the
+// app's ReplayDialog. The frame is one QImage reused for every game, and
+// each move repaints only its own cell. A palette-index copy of the frame
+// is kept in step for the GIF writer. Drawing is not antialiased, so every
+// pixel is exactly one of the palette colours.
+class ReplayRenderer
+{
+public:
+    explicit ReplayRenderer(int cellSize);
+
+    static std::vector<uint32_t> palette();
+
+    // Starts a new game on an empty board.
+    void reset();
+    // Draws one move and returns the rectangle that changed; the rectangle
+    // is empty for moves off the board or onto an occupied cell.
+    QRect playMove(const Move &m);
+
+    const QImage &frame() const;
+    const uint8_t *indices() const;
+    int stride() const;
+
+private:
+    void paintCell(int row, int col, char player);
+
+    int cellSize;
+    QImage image;
+    std::vector<uint8_t> indexBuffer;
+    BoardState board;
+};
+
+#endif // REPLAYRENDERER_H
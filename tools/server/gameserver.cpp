@@ -0,0 +1,222 @@
+#include "gameserver.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QThread>
+#include <QtConcurrent>
+#include <QDebug>
+
+// Result of one AI search, handed back from the worker pool.
+struct AiReply {
+    int row;
+    int col;
+};
+
+// ------------------------------------------------------------------
+// GameSession Implementation
+
+GameSession::GameSession(QTcpSocket *socket, QThreadPool *aiPool, const QString &historyDir,
+                         QObject *parent)
+    : QObject(parent), socket(socket), aiPool(aiPool), historyDir(historyDir),
+      board(emptyBoard()), currentPlayer('X'), gameMode(0), gameActive(false), aiThinking(false)
+{
+    socket->setParent(this);
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QTcpSocket::readyRead, this, &GameSession::onReadyRead);
+    connect(socket, &QTcpSocket::disconnected, this, &QObject::deleteLater);
+}
+
+GameSession::~GameSession()
+{
+}
+
+void GameSession::onReadyRead()
+{
+    while (socket->canReadLine())
+    {
+        QString line = QString::fromLatin1(socket->readLine()).trimmed();
+        if (!line.isEmpty())
+            handleCommand(line);
+    }
+    // Drop clients that send an endless line without a newline.
+    if (socket->bytesAvailable() > 1024)
+        socket->abort();
+}
+
+void GameSession::handleCommand(const QString &line)
+{
+    QStringList parts = line.split(' ', Qt::SkipEmptyParts);
+    const QString command = parts[0].toUpper();
+
+    if (command == "USER" && parts.size() == 2)
+    {
+        // The name becomes part of a file path, so keep it to plain characters.
+        static const QRegularExpression validName("^[A-Za-z0-9_]{1,64}$");
+        if (!validName.match(parts[1]).hasMatch())
+        {
+            send("ERR invalid user name");
+            return;
+        }
+        user = parts[1];
+        send("OK");
+    }
+    else if (command == "NEW" && parts.size() == 2)
+    {
+        const QString mode = parts[1].toUpper();
+        if (mode == "PVP")
+            startGame(1);
+        else if (mode == "PVAI")
+            startGame(2);
+        else
+            send("ERR unknown mode");
+    }
+    else if (command == "MOVE" && parts.size() == 3)
+    {
+        bool rowOk = false, colOk = false;
+        int row = parts[1].toInt(&rowOk);
+        int col = parts[2].toInt(&colOk);
+        if (!gameActive)
+            send("ERR no game");
+        else if (aiThinking || (gameMode == 2 && currentPlayer == 'O'))
+            send("ERR not your turn");
+        else if (!rowOk || !colOk || row < 0 || row >= 3 || col < 0 || col >= 3 || board[row][col] != ' ')
+            send("ERR illegal move");
+        else
+            applyMove(row, col);
+    }
+    else if (command == "QUIT")
+    {
+        socket->disconnectFromHost();
+    }
+    else
+    {
+        send("ERR unknown command");
+    }
+}
+
+void GameSession::startGame(int mode)
+{
+    if (aiThinking)
+    {
+        send("ERR busy");
+        return;
+    }
+    board = emptyBoard();
+    moves.clear();
+    currentPlayer = 'X';
+    gameMode = mode;
+    gameActive = true;
+    send("OK");
+}
+
+void GameSession::applyMove(int row, int col)
+{
+    board[row][col] = currentPlayer;
+    moves.push_back(Move{ row, col, currentPlayer });
+    send(QString("MOVED %1 %2 %3").arg(row).arg(col).arg(QChar(currentPlayer)));
+
+    if (evalIsWinner(board, currentPlayer))
+    {
+        QString winnerName = (currentPlayer == 'X') ? "You" : "AI";
+        if (gameMode == 1)
+            winnerName = (currentPlayer == 'X') ? "Player 1" : "Player 2";
+        finishGame(winnerName);
+        return;
+    }
+    if (evalIsFull(board))
+    {
+        finishGame("Draw");
+        return;
+    }
+
+    currentPlayer = (currentPlayer == 'X') ? 'O' : 'X';
+    if (gameMode == 2 && currentPlayer == 'O')
+    {
+        // Search on the worker pool so one slow search never stalls other sessions.
+        aiThinking = true;
+        auto *watcher = new QFutureWatcher<AiReply>(this);
+        connect(watcher, &QFutureWatcher<AiReply>::finished, this, &GameSession::onAiMoveReady);
+        BoardState snapshot = board;
+        watcher->setFuture(QtConcurrent::run(aiPool, [snapshot]() {
+            AiReply reply = { -1, -1 };
+            evalBestMove(snapshot, reply.row, reply.col);
+            return reply;
+        }));
+    }
+}
+
+void GameSession::onAiMoveReady()
+{
+    auto *watcher = static_cast<QFutureWatcher<AiReply>*>(sender());
+    AiReply reply = watcher->result();
+    watcher->deleteLater();
+    aiThinking = false;
+    if (gameActive && reply.row != -1)
+        applyMove(reply.row, reply.col);
+}
+
+void GameSession::finishGame(const QString &winner)
+{
+    gameActive = false;
+    send("OVER " + winner);
+    if (user.isEmpty())
+        return;
+
+    // Same line format as MainWindow::saveGameHistory, appended per game.
+    GameRecord record;
+    record.mode = (gameMode == 1) ? "PvP" : "PvAI";
+    record.winner = winner.toStdString();
+    record.moves = moves;
+    QFile file(QDir(historyDir).filePath(user + "_history.txt"));
+    if (file.open(QIODevice::Append | QIODevice::Text))
+    {
+        QTextStream out(&file);
+        out << QString::fromStdString(encodeGameRecord(record)) << "\n";
+        file.close();
+    }
+    else
+        qWarning() << "Could not write to history file" << file.fileName();
+}
+
+void GameSession::send(const QString &line)
+{
+    socket->write(line.toLatin1() + '\n');
+}
+
+// ------------------------------------------------------------------
+// GameServer Implementation
+
+GameServer::GameServer(const QString &historyDir, int aiThreads, QObject *parent)
+    : QObject(parent), historyDir(historyDir)
+{
+    aiPool.setMaxThreadCount(aiThreads > 0 ? aiThreads : QThread::idealThreadCount());
+    tcpServer = new QTcpServer(this);
+    tcpServer->setMaxPendingConnections(4096);
+    connect(tcpServer, &QTcpServer::newConnection, this, &GameServer::onNewConnection);
+}
+
+GameServer::~GameServer()
+{
+    // Sessions own their sockets and may still have searches queued.
+    aiPool.clear();
+    aiPool.waitForDone();
+}
+
+bool GameServer::listen(const QHostAddress &address, quint16 port)
+{
+    return tcpServer->listen(address, port);
+}
+
+QString GameServer::errorString() const
+{
+    return tcpServer->errorString();
+}
+
+void GameServer::onNewConnection()
+{
+    while (QTcpSocket *socket = tcpServer->nextPendingConnection())
+        new GameSession(socket, &aiPool, historyDir, this);
+}
@@ -0,0 +1,77 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThreadPool>
+#include <QString>
+#include <vector>
+
+#include "gamecore.h"
+
+// --- GameSession Class Definition ---
+// One connected client playing one game at a time. Commands are single
+// text lines:
+//   USER <name>        records finished games in <name>_history.txt
+//   NEW PVP | NEW PVAI starts a new game (X always moves first)
+//   MOVE <row> <col>   plays the current player's move
+//   QUIT               closes the connection
+// Replies are "OK", "MOVED <row> <col> <player>", "OVER <winner>" and
+// "ERR <reason>".
+class GameSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    GameSession(QTcpSocket *socket, QThreadPool *aiPool, const QString &historyDir,
+                QObject *parent = nullptr);
+    ~GameSession();
+
+private slots:
+    void onReadyRead();
+    void onAiMoveReady();
+
+private:
+    void handleCommand(const QString &line);
+    void startGame(int mode);
+    void applyMove(int row, int col);
+    void finishGame(const QString &winner);
+    void send(const QString &line);
+
+    QTcpSocket *socket;
+    QThreadPool *aiPool;
+    QString historyDir;
+    QString user;
+    BoardState board;
+    std::vector<Move> moves;
+    char currentPlayer;
+    int gameMode;      // 0 = no game, 1 = PvP, 2 = PvAI
+    bool gameActive;
+    bool aiThinking;
+};
+
+// --- GameServer Class Definition ---
+// Accepts TCP connections and gives each one its own GameSession. All socket
+// I/O runs on the event loop thread; AI searches run on a worker pool.
+class GameServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    GameServer(const QString &historyDir, int aiThreads, QObject *parent = nullptr);
+    ~GameServer();
+
+    bool listen(const QHostAddress &address, quint16 port);
+    QString errorString() const;
+
+private slots:
+    void onNewConnection();
+
+private:
+    QTcpServer *tcpServer;
+    QThreadPool aiPool;
+    QString historyDir;
+};
+
+#endif // GAMESERVER_H
@@ -0,0 +1,34 @@
+#include "gameserver.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHostAddress>
+#include <QDebug>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-server");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless tic-tac-toe server for many concurrent PvP and PvAI games.");
+    parser.addHelpOption();
+    QCommandLineOption hostOption("host", "Address to listen on.", "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "TCP port to listen on.", "port", "5555");
+    QCommandLineOption historyOption("history-dir", "Directory for <user>_history.txt files.", "dir", ".");
+    QCommandLineOption threadsOption("ai-threads", "Worker threads for AI searches (0 = one per core).", "count", "0");
+    parser.addOption(hostOption);
+    parser.addOption(portOption);
+    parser.addOption(historyOption);
+    parser.addOption(threadsOption);
+    parser.process(app);
+
+    GameServer server(parser.value(historyOption), parser.value(threadsOption).toInt());
+    if (!server.listen(QHostAddress(parser.value(hostOption)), parser.value(portOption).toUShort()))
+    {
+        qCritical() << "Could not listen:" << server.errorString();
+        return 1;
+    }
+    qInfo() << "Listening on" << parser.value(hostOption) << "port" << parser.value(portOption);
+    return app.exec();
+}
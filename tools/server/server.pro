@@ -0,0 +1,15 @@
+QT = core network concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-server
+
+SOURCES += \
+    main.cpp \
+    gameserver.cpp
+
+HEADERS += \
+    gameserver.h
+
+include(../../core/core.pri)
@@ -0,0 +1,133 @@
+#include "perft.h"
+#include "proofsearch.h"
+#include "tablebase.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+
+static QString valueName(int value)
+{
+    switch (value)
+    {
+    case TB_WIN: return "first player wins";
+    case TB_LOSS: return "second player wins";
+    case TB_DRAW: return "draw";
+    default: return "invalid";
+    }
+}
+
+// Proves one position with df-pn instead of solving every position, which
+// reaches boards far beyond the tablebase limit when the result is forced.
+static int provePosition(const Variant &variant, const Position &pos, uint64_t maxNodes, size_t tableBytes,
+                         int timeMs, QTextStream &out)
+{
+    ProofSolver solver(tableBytes);
+    out << "Proving " << variant.size << "x" << variant.size << " k=" << variant.k << " with "
+        << (maxNodes ? QString::number(maxNodes) : QString("unlimited")) << " nodes...\n";
+    out.flush();
+    QElapsedTimer timer;
+    timer.start();
+    const ProofResult result = solver.solve(variant, pos, maxNodes, timeMs);
+    const double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-9);
+
+    out << "nodes:      " << result.nodes << "\n";
+    out << "table:      " << solver.tableUsed() << " of " << solver.tableEntries() << " entries ("
+        << solver.tableBytes() << " bytes)\n";
+    out << "time:       " << QString::number(seconds, 'f', 2) << " s\n";
+    out << "throughput: " << QString::number(result.nodes / seconds, 'f', 0) << " nodes/s\n";
+    out << "result:     " << proofValueName(result.value) << " for " << sideToMove(pos);
+    if (result.value == PROOF_WIN)
+        out << ", playing row " << result.cell / variant.size + 1 << " column " << result.cell % variant.size + 1;
+    out << "\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-solver");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Solves a k-in-a-row variant completely and writes a 2-bit-per-position tablebase, "
+                                     "or proves a single position with df-pn (--proof).");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size", "Board size (size x size).", "n", "4");
+    QCommandLineOption kOption("k", "Stones in a row needed to win.", "k", "4");
+    QCommandLineOption threadsOption("threads", "Solver threads (0 = one per core).", "count", "0");
+    QCommandLineOption outputOption("output", "Tablebase file to write.", "file");
+    QCommandLineOption proofOption("proof", "Prove --position with df-pn instead of writing a tablebase.");
+    QCommandLineOption positionOption("position", "Row-major board of X, O and . for --proof (default empty).", "board");
+    QCommandLineOption proofNodesOption("proof-nodes", "Node budget for --proof (0 = none).", "count", "10000000");
+    QCommandLineOption proofTableOption("proof-table-mb", "Transposition table for --proof, in MiB.", "mb", "64");
+    QCommandLineOption timeOption("time", "Time limit for --proof in ms (0 = none).", "ms", "0");
+    parser.addOption(sizeOption);
+    parser.addOption(kOption);
+    parser.addOption(threadsOption);
+    parser.addOption(outputOption);
+    parser.addOption(proofOption);
+    parser.addOption(positionOption);
+    parser.addOption(proofNodesOption);
+    parser.addOption(proofTableOption);
+    parser.addOption(timeOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    const int size = parser.value(sizeOption).toInt();
+    const int k = parser.value(kOption).toInt();
+    int threads = parser.value(threadsOption).toInt();
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    QString output = parser.value(outputOption);
+    if (output.isEmpty())
+        output = QString("ttt-%1x%1-k%2.tb").arg(size).arg(k);
+
+    Variant variant = makeVariant(size, k);
+    if (variant.cells == 0)
+    {
+        err << "Invalid board size or k.\n";
+        return 1;
+    }
+
+    if (parser.isSet(proofOption))
+    {
+        Position pos = { 0, 0 };
+        if (parser.isSet(positionOption) && !parsePosition(variant, parser.value(positionOption).toStdString(), pos))
+        {
+            err << "Invalid position: " << parser.value(positionOption) << "\n";
+            return 1;
+        }
+        const size_t tableBytes = static_cast<size_t>(std::max(1, parser.value(proofTableOption).toInt())) << 20;
+        return provePosition(variant, pos, parser.value(proofNodesOption).toULongLong(), tableBytes,
+                             std::max(0, parser.value(timeOption).toInt()), out);
+    }
+
+    TablebaseStats stats;
+    std::string error;
+    out << "Solving " << size << "x" << size << " k=" << k << " on " << threads << " threads...\n";
+    out.flush();
+    if (!solveTablebase(variant, threads, output.toStdString(), &stats, &error))
+    {
+        err << QString::fromStdString(error) << "\n";
+        return 1;
+    }
+
+    // Re-open through the mapped reader so the written file is checked too.
+    Tablebase tablebase;
+    if (!tablebase.open(output.toStdString()) || tablebase.probe(Position{ 0, 0 }) != stats.rootValue)
+    {
+        err << "Written tablebase failed verification.\n";
+        return 1;
+    }
+
+    out << "positions:  " << stats.positions << "\n";
+    out << "file:       " << output << " (" << stats.bytes << " bytes)\n";
+    out << "time:       " << QString::number(stats.seconds, 'f', 2) << " s\n";
+    out << "throughput: " << QString::number(stats.positions / std::max(stats.seconds, 1e-9), 'f', 0) << " positions/s\n";
+    out << "result:     " << valueName(stats.rootValue) << "\n";
+    return 0;
+}
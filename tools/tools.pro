@@ -0,0 +1,14 @@
+# Headless command-line targets built on top of the shared game core.
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    server \
+    loadgen \
+    solver \
+    bench \
+    perft \
+    render \
+    tournament \
+    trainer \
+    fuzz
@@ -0,0 +1,361 @@
+#include "neuralnet.h"
+#include "proofsearch.h"
+#include "search.h"
+#include "tablebase.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+
+// One game of a pairing. X is engines[first], O is engines[second].
+struct GameTask {
+    const Variant *variant;
+    const std::vector<EngineConfig> *engines;
+    int first;
+    int second;
+    int openingPlies;
+    uint64_t openingSeed;
+};
+
+// Per-side totals of one game.
+struct SideStats {
+    uint64_t nanoseconds;
+    uint64_t nodes;
+    uint64_t depth;
+    int moves;
+    int proved; // moves played from a proven win (df-pn or tablebase)
+};
+
+struct GameResult {
+    int first;
+    int second;
+    double firstScore; // 1 = X (first) won, 0.5 = draw, 0 = O won
+    SideStats sides[2];
+};
+
+// Engine-level totals across the tournament.
+struct EngineTotals {
+    std::vector<double> scores;
+    SideStats stats;
+};
+
+// Parses "name:depth=4,time=50,ab=0,proof=100000,proofmb=16,net=file,tb=file";
+// missing keys keep their defaults. The network and tablebase files are
+// only named here; main() loads them.
+static bool parseEngine(const QString &text, EngineConfig &engine, QString &networkPath, QString &tablebasePath)
+{
+    const QStringList parts = text.split(':');
+    engine.name = parts[0].toStdString();
+    engine.depth = 4;
+    engine.timeMs = 0;
+    engine.alphaBeta = true;
+    engine.network = nullptr;
+    engine.proofNodes = 0;
+    engine.proofTableBytes = 0;
+    engine.tablebase = nullptr;
+    networkPath.clear();
+    tablebasePath.clear();
+    if (engine.name.empty() || parts.size() > 2)
+        return false;
+    if (parts.size() == 1)
+        return true;
+    for (const QString &setting : parts[1].split(',', Qt::SkipEmptyParts))
+    {
+        const QStringList keyValue = setting.split('=');
+        if (keyValue.size() == 2 && keyValue[0] == "net")
+        {
+            networkPath = keyValue[1];
+            continue;
+        }
+        if (keyValue.size() == 2 && keyValue[0] == "tb")
+        {
+            tablebasePath = keyValue[1];
+            continue;
+        }
+        bool ok = keyValue.size() == 2;
+        const int value = ok ? keyValue[1].toInt(&ok) : 0;
+        if (!ok)
+            return false;
+        if (keyValue[0] == "depth")
+            engine.depth = value;
+        else if (keyValue[0] == "time")
+            engine.timeMs = value;
+        else if (keyValue[0] == "ab")
+            engine.alphaBeta = value != 0;
+        else if (keyValue[0] == "proof" && value >= 0)
+            engine.proofNodes = static_cast<uint64_t>(value);
+        else if (keyValue[0] == "proofmb" && value > 0)
+            engine.proofTableBytes = static_cast<size_t>(value) << 20;
+        else
+            return false;
+    }
+    return true;
+}
+
+static GameResult playGame(const GameTask &task)
+{
+    const Variant &variant = *task.variant;
+    GameResult result;
+    result.first = task.first;
+    result.second = task.second;
+    result.firstScore = 0.5;
+    for (SideStats &side : result.sides)
+        side = SideStats{ 0, 0, 0, 0, 0 };
+
+    // Random opening moves, shared by both games of a colour-swapped pair.
+    Position pos = { 0, 0 };
+    std::mt19937_64 random(task.openingSeed);
+    for (int ply = 0; ply < task.openingPlies; ++ply)
+    {
+        CellMask empty = emptyCells(variant, pos);
+        int skip = static_cast<int>(random() % popCount(empty));
+        while (skip-- > 0)
+            empty &= empty - 1;
+        Position next = pos;
+        (sideToMove(pos) == 'X' ? next.x : next.o) |= empty & (~empty + 1);
+        if (hasLine(variant, next.x) || hasLine(variant, next.o) || emptyCells(variant, next) == 0)
+            break;
+        pos = next;
+    }
+
+    while (true)
+    {
+        const int side = sideToMove(pos) == 'X' ? 0 : 1;
+        const EngineConfig &engine = (*task.engines)[side == 0 ? task.first : task.second];
+        const auto start = std::chrono::steady_clock::now();
+        const SearchResult move = searchMove(variant, pos, engine);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        if (move.cell < 0)
+            break;
+        SideStats &stats = result.sides[side];
+        stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        stats.nodes += move.nodes + move.proofNodes;
+        stats.depth += move.depth;
+        stats.moves++;
+        if (move.proof == PROOF_WIN)
+            stats.proved++;
+
+        (side == 0 ? pos.x : pos.o) |= cellBit(move.cell);
+        if (hasLine(variant, side == 0 ? pos.x : pos.o))
+        {
+            result.firstScore = side == 0 ? 1.0 : 0.0;
+            break;
+        }
+        if (emptyCells(variant, pos) == 0)
+            break;
+    }
+    return result;
+}
+
+// Elo difference for an expected score, clamped so perfect scores stay finite.
+static double eloFromScore(double score)
+{
+    score = std::min(std::max(score, 0.001), 0.999);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Elo estimate and 95% error bar from per-game scores (1, 0.5 or 0).
+static void eloWithError(const std::vector<double> &scores, double &elo, double &margin)
+{
+    const double n = static_cast<double>(scores.size());
+    double sum = 0, squares = 0;
+    for (double s : scores)
+    {
+        sum += s;
+        squares += s * s;
+    }
+    const double mean = sum / n;
+    const double deviation = std::sqrt(std::max(squares / n - mean * mean, 0.0) / n);
+    elo = eloFromScore(mean);
+    margin = (eloFromScore(mean + 1.96 * deviation) - eloFromScore(mean - 1.96 * deviation)) / 2.0;
+}
+
+static void addSide(SideStats &total, const SideStats &side)
+{
+    total.nanoseconds += side.nanoseconds;
+    total.nodes += side.nodes;
+    total.depth += side.depth;
+    total.moves += side.moves;
+    total.proved += side.proved;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-tournament");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Plays engine configurations against each other and estimates their Elo.");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size", "Board size (size x size).", "n", "5");
+    QCommandLineOption kOption("k", "Stones in a row needed to win.", "k", "4");
+    QCommandLineOption engineOption("engine", "Engine as name:depth=D,time=MS,ab=0|1,proof=NODES,proofmb=MB,net=FILE,"
+                                              "tb=FILE (repeatable).", "spec");
+    QCommandLineOption modeOption("mode", "roundrobin, or gauntlet (first engine against each other one).", "mode", "roundrobin");
+    QCommandLineOption roundsOption("rounds", "Openings per pairing; each is played with both colours.", "count", "50");
+    QCommandLineOption openingOption("opening-plies", "Random moves played before the engines take over.", "plies", "2");
+    QCommandLineOption threadsOption("threads", "Games played at once (0 = one per core).", "count", "0");
+    QCommandLineOption seedOption("seed", "Seed for the random openings.", "seed", "1");
+    parser.addOption(sizeOption);
+    parser.addOption(kOption);
+    parser.addOption(engineOption);
+    parser.addOption(modeOption);
+    parser.addOption(roundsOption);
+    parser.addOption(openingOption);
+    parser.addOption(threadsOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    const Variant variant = makeVariant(parser.value(sizeOption).toInt(), parser.value(kOption).toInt());
+    if (variant.cells == 0)
+    {
+        err << "Invalid board size or k.\n";
+        return 1;
+    }
+
+    QStringList specs = parser.values(engineOption);
+    if (specs.isEmpty())
+        specs << "depth2:depth=2" << "depth4:depth=4" << "depth6:depth=6" << "time20ms:depth=64,time=20";
+    std::vector<EngineConfig> engines;
+    std::deque<NeuralNet> networks; // stable addresses for EngineConfig::network
+    std::deque<Tablebase> tablebases; // and for EngineConfig::tablebase
+    for (const QString &spec : specs)
+    {
+        EngineConfig engine;
+        QString networkPath, tablebasePath;
+        if (!parseEngine(spec, engine, networkPath, tablebasePath))
+        {
+            err << "Invalid engine: " << spec << "\n";
+            return 1;
+        }
+        if (!networkPath.isEmpty())
+        {
+            networks.emplace_back();
+            std::string error;
+            if (!networks.back().load(networkPath.toStdString(), &error))
+            {
+                err << QString::fromStdString(error) << "\n";
+                return 1;
+            }
+            if (!networks.back().matches(variant))
+            {
+                err << networkPath << " was trained for another board size or k.\n";
+                return 1;
+            }
+            engine.network = &networks.back();
+        }
+        if (!tablebasePath.isEmpty())
+        {
+            tablebases.emplace_back();
+            if (!tablebases.back().open(tablebasePath.toStdString()))
+            {
+                err << "Cannot open tablebase: " << tablebasePath << "\n";
+                return 1;
+            }
+            if (tablebases.back().variant().size != variant.size || tablebases.back().variant().k != variant.k)
+            {
+                err << tablebasePath << " was solved for another board size or k.\n";
+                return 1;
+            }
+            engine.tablebase = &tablebases.back();
+        }
+        engines.push_back(engine);
+    }
+    if (engines.size() < 2)
+    {
+        err << "At least two engines are needed.\n";
+        return 1;
+    }
+    const bool gauntlet = parser.value(modeOption) == "gauntlet";
+    const int rounds = std::max(1, parser.value(roundsOption).toInt());
+    const int openingPlies = std::max(0, parser.value(openingOption).toInt());
+    const uint64_t seed = parser.value(seedOption).toULongLong();
+    int threads = parser.value(threadsOption).toInt();
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+
+    std::vector<GameTask> tasks;
+    for (int a = 0; a < static_cast<int>(engines.size()); ++a)
+    {
+        for (int b = a + 1; b < static_cast<int>(engines.size()); ++b)
+        {
+            if (gauntlet && a != 0)
+                continue;
+            for (int round = 0; round < rounds; ++round)
+            {
+                const uint64_t openingSeed = seed * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(round);
+                tasks.push_back(GameTask{ &variant, &engines, a, b, openingPlies, openingSeed });
+                tasks.push_back(GameTask{ &variant, &engines, b, a, openingPlies, openingSeed });
+            }
+        }
+    }
+
+    out << variant.size << "x" << variant.size << " k=" << variant.k << ", " << engines.size() << " engines, "
+        << tasks.size() << " games on " << threads << " threads\n";
+    out.flush();
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    QElapsedTimer timer;
+    timer.start();
+    const QList<GameResult> results = QtConcurrent::mapped(tasks, playGame).results();
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    std::vector<EngineTotals> totals(engines.size());
+    for (EngineTotals &total : totals)
+        total.stats = SideStats{ 0, 0, 0, 0, 0 };
+    for (const GameResult &game : results)
+    {
+        totals[game.first].scores.push_back(game.firstScore);
+        totals[game.second].scores.push_back(1.0 - game.firstScore);
+        addSide(totals[game.first].stats, game.sides[0]);
+        addSide(totals[game.second].stats, game.sides[1]);
+    }
+
+    std::vector<int> ranking(engines.size());
+    std::vector<double> elo(engines.size()), margin(engines.size());
+    for (size_t i = 0; i < engines.size(); ++i)
+    {
+        ranking[i] = static_cast<int>(i);
+        eloWithError(totals[i].scores, elo[i], margin[i]);
+    }
+    std::stable_sort(ranking.begin(), ranking.end(), [&](int a, int b) { return elo[a] > elo[b]; });
+
+    out << "\n" << QString("engine").leftJustified(16) << qSetFieldWidth(8) << "games" << "score"
+        << qSetFieldWidth(16) << "Elo" << qSetFieldWidth(12) << "ms/move" << "nodes/move" << "depth"
+        << "proved" << qSetFieldWidth(0) << "\n";
+    for (int i : ranking)
+    {
+        const EngineTotals &total = totals[i];
+        double points = 0;
+        for (double s : total.scores)
+            points += s;
+        const double moves = std::max(total.stats.moves, 1);
+        out << QString::fromStdString(engines[i].name).leftJustified(16)
+            << qSetFieldWidth(8) << total.scores.size()
+            << QString::number(100.0 * points / total.scores.size(), 'f', 1) + "%"
+            << qSetFieldWidth(16)
+            << QString("%1 +/- %2").arg(elo[i], 0, 'f', 0).arg(margin[i], 0, 'f', 0)
+            << qSetFieldWidth(12)
+            << QString::number(total.stats.nanoseconds / moves / 1e6, 'f', 3)
+            << QString::number(total.stats.nodes / moves, 'f', 0)
+            << QString::number(total.stats.depth / moves, 'f', 1)
+            << QString::number(100.0 * total.stats.proved / moves, 'f', 1) + "%"
+            << qSetFieldWidth(0) << "\n";
+    }
+    out << "\nElo is relative to the average opponent faced, with a 95% error bar. Nodes include df-pn\n"
+           "nodes; proved is the share of moves played from a proven win.\n";
+    out << "time: " << QString::number(seconds, 'f', 2) << " s, "
+        << QString::number(results.size() / std::max(seconds, 1e-9), 'f', 1) << " games/s\n";
+    return 0;
+}
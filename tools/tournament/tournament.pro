@@ -0,0 +1,11 @@
+QT = core concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-tournament
+
+SOURCES += \
+    main.cpp
+
+include(../../core/core.pri)
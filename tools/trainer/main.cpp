@@ -0,0 +1,340 @@
+#include "gamecore.h"
+#include "neuralnet.h"
+#include "search.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// A training position and its final result for the side to move
+// (1 win, 0 draw, -1 loss).
+struct Sample {
+    Position pos;
+    float target;
+};
+
+struct SelfPlayTask {
+    const Variant *variant;
+    const EngineConfig *engine;
+    int openingPlies;
+    double randomRate; // chance of a random move instead of the engine's
+    uint64_t seed;
+};
+
+static int randomEmptyCell(const Variant &variant, const Position &pos, std::mt19937_64 &random)
+{
+    CellMask empty = emptyCells(variant, pos);
+    int skip = static_cast<int>(random() % popCount(empty));
+    while (skip-- > 0)
+        empty &= empty - 1;
+    return lowestCell(empty);
+}
+
+// Labels every position of a finished game with its result.
+static void addGame(const std::vector<Position> &positions, char winner, std::vector<Sample> &samples)
+{
+    for (const Position &pos : positions)
+    {
+        const float target = winner == ' ' ? 0.0f : (sideToMove(pos) == winner ? 1.0f : -1.0f);
+        samples.push_back(Sample{ pos, target });
+    }
+}
+
+static std::vector<Sample> playSelfPlayGame(const SelfPlayTask &task)
+{
+    const Variant &variant = *task.variant;
+    std::mt19937_64 random(task.seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::vector<Position> positions;
+    Position pos = { 0, 0 };
+    char winner = ' ';
+    for (int ply = 0; emptyCells(variant, pos) != 0; ++ply)
+    {
+        const char side = sideToMove(pos);
+        if (ply >= task.openingPlies)
+            positions.push_back(pos);
+        int cell;
+        if (ply < task.openingPlies || chance(random) < task.randomRate)
+            cell = randomEmptyCell(variant, pos, random);
+        else
+            cell = searchMove(variant, pos, *task.engine).cell;
+        (side == 'X' ? pos.x : pos.o) |= cellBit(cell);
+        if (hasLine(variant, side == 'X' ? pos.x : pos.o))
+        {
+            winner = side;
+            break;
+        }
+    }
+    std::vector<Sample> samples;
+    addGame(positions, winner, samples);
+    return samples;
+}
+
+// Replays stored 3x3 games; the winner is taken from the moves themselves
+// because the record's winner field holds display names.
+static bool loadHistory(const QString &path, const Variant &variant, std::vector<Sample> &samples, int &games)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    QTextStream in(&file);
+    while (!in.atEnd())
+    {
+        GameRecord record;
+        if (!decodeGameRecord(in.readLine().toStdString(), record) || record.moves.empty() ||
+            isUltimateRecord(record))
+            continue;
+        std::vector<Position> positions;
+        Position pos = { 0, 0 };
+        char winner = ' ';
+        bool valid = true;
+        for (const Move &m : record.moves)
+        {
+            const int cell = m.row * variant.size + m.col;
+            if (m.row < 0 || m.col < 0 || m.row >= variant.size || m.col >= variant.size ||
+                m.player != sideToMove(pos) || !(emptyCells(variant, pos) & cellBit(cell)))
+            {
+                valid = false;
+                break;
+            }
+            positions.push_back(pos);
+            (m.player == 'X' ? pos.x : pos.o) |= cellBit(cell);
+            if (hasLine(variant, m.player == 'X' ? pos.x : pos.o))
+            {
+                winner = m.player;
+                break;
+            }
+        }
+        if (!valid)
+            continue;
+        addGame(positions, winner, samples);
+        games++;
+    }
+    return true;
+}
+
+// One stochastic gradient step on (tanh(output) - target)^2. Returns the
+// loss before the update.
+static float trainSample(NeuralNet &net, const Variant &variant, const Sample &sample, float rate,
+                         std::vector<float> &accumulator)
+{
+    NeuralWeights &w = net.weights();
+    const int hidden = w.hidden;
+    const char side = sideToMove(sample.pos);
+    net.refresh(sample.pos, accumulator.data());
+    const float *values = accumulator.data() + (side == 'X' ? 0 : hidden);
+    const float y = std::tanh(net.evaluate(accumulator.data(), side));
+    const float error = y - sample.target;
+    const float delta = 2.0f * error * (1.0f - y * y);
+
+    const CellMask own = side == 'X' ? sample.pos.x : sample.pos.o;
+    const CellMask other = side == 'X' ? sample.pos.o : sample.pos.x;
+    for (int j = 0; j < hidden; ++j)
+    {
+        const float value = values[j];
+        const float outputWeight = w.output[j];
+        w.output[j] -= rate * delta * std::min(std::max(value, 0.0f), 1.0f);
+        if (value <= 0.0f || value >= 1.0f)
+            continue; // clipped: no gradient reaches the first layer
+        const float step = rate * delta * outputWeight;
+        w.inputBias[j] -= step;
+        for (CellMask stones = own; stones; stones &= stones - 1)
+            w.input[static_cast<size_t>(lowestCell(stones)) * hidden + j] -= step;
+        for (CellMask stones = other; stones; stones &= stones - 1)
+            w.input[static_cast<size_t>(variant.cells + lowestCell(stones)) * hidden + j] -= step;
+    }
+    w.outputBias -= rate * delta;
+    return error * error;
+}
+
+// Mean loss and the share of positions whose rounded prediction (win above
+// 1/3, loss below -1/3, else draw) matches the result.
+static void measure(const NeuralNet &net, const std::vector<Sample> &samples, size_t begin, size_t end,
+                    double &loss, double &accuracy)
+{
+    std::vector<Position> positions;
+    for (size_t i = begin; i < end; ++i)
+        positions.push_back(samples[i].pos);
+    std::vector<float> outputs(positions.size());
+    net.evaluateBatch(positions.data(), positions.size(), outputs.data());
+    loss = 0.0;
+    int correct = 0;
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        const float y = std::tanh(outputs[i]);
+        const float target = samples[begin + i].target;
+        loss += (y - target) * (y - target);
+        const float predicted = y > 1.0f / 3 ? 1.0f : (y < -1.0f / 3 ? -1.0f : 0.0f);
+        if (predicted == target)
+            correct++;
+    }
+    const double count = std::max<size_t>(positions.size(), 1);
+    loss /= count;
+    accuracy = 100.0 * correct / count;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tictactoe-trainer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Trains the neural position evaluator from self-play or stored games.");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size", "Board size (size x size).", "n", "5");
+    QCommandLineOption kOption("k", "Stones in a row needed to win.", "k", "4");
+    QCommandLineOption historyOption("history", "Train on a history file (<user>_history.txt, 3x3) instead of self-play.", "file");
+    QCommandLineOption gamesOption("games", "Self-play games to generate.", "count", "2000");
+    QCommandLineOption depthOption("depth", "Search depth of the self-play engine.", "plies", "2");
+    QCommandLineOption openingOption("opening-plies", "Random moves at the start of each self-play game.", "plies", "2");
+    QCommandLineOption randomOption("random-rate", "Chance of a random self-play move after the opening.", "rate", "0.1");
+    QCommandLineOption hiddenOption("hidden", "Hidden units (rounded up to a multiple of 8).", "count", "32");
+    QCommandLineOption epochsOption("epochs", "Passes over the training positions.", "count", "10");
+    QCommandLineOption rateOption("rate", "Learning rate.", "rate", "0.01");
+    QCommandLineOption inputOption("net", "Continue from this network; self-play then searches with it.", "file");
+    QCommandLineOption outputOption("output", "Where to write the trained network.", "file", "network.ttnn");
+    QCommandLineOption threadsOption("threads", "Self-play games at once (0 = one per core).", "count", "0");
+    QCommandLineOption seedOption("seed", "Seed for openings, initial weights and shuffling.", "seed", "1");
+    parser.addOption(sizeOption);
+    parser.addOption(kOption);
+    parser.addOption(historyOption);
+    parser.addOption(gamesOption);
+    parser.addOption(depthOption);
+    parser.addOption(openingOption);
+    parser.addOption(randomOption);
+    parser.addOption(hiddenOption);
+    parser.addOption(epochsOption);
+    parser.addOption(rateOption);
+    parser.addOption(inputOption);
+    parser.addOption(outputOption);
+    parser.addOption(threadsOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    const bool fromHistory = parser.isSet(historyOption);
+    const Variant variant = fromHistory ? makeVariant(3, 3)
+                                        : makeVariant(parser.value(sizeOption).toInt(), parser.value(kOption).toInt());
+    if (variant.cells == 0)
+    {
+        err << "Invalid board size or k.\n";
+        return 1;
+    }
+    const uint64_t seed = parser.value(seedOption).toULongLong();
+
+    NeuralNet net;
+    if (parser.isSet(inputOption))
+    {
+        std::string error;
+        if (!net.load(parser.value(inputOption).toStdString(), &error))
+        {
+            err << QString::fromStdString(error) << "\n";
+            return 1;
+        }
+        if (!net.matches(variant))
+        {
+            err << parser.value(inputOption) << " was trained for another board size or k.\n";
+            return 1;
+        }
+    }
+    else
+    {
+        net.initialize(variant, parser.value(hiddenOption).toInt(), seed);
+    }
+
+    std::vector<Sample> samples;
+    QElapsedTimer timer;
+    timer.start();
+    if (fromHistory)
+    {
+        int games = 0;
+        if (!loadHistory(parser.value(historyOption), variant, samples, games))
+        {
+            err << "Cannot open history file: " << parser.value(historyOption) << "\n";
+            return 1;
+        }
+        out << "Loaded " << games << " games, " << samples.size() << " positions\n";
+    }
+    else
+    {
+        EngineConfig engine;
+        engine.name = "selfplay";
+        engine.depth = std::max(1, parser.value(depthOption).toInt());
+        engine.timeMs = 0;
+        engine.alphaBeta = true;
+        engine.network = parser.isSet(inputOption) ? &net : nullptr;
+        engine.proofNodes = 0;
+        engine.proofTableBytes = 0;
+        engine.tablebase = nullptr;
+
+        int threads = parser.value(threadsOption).toInt();
+        if (threads <= 0)
+            threads = QThread::idealThreadCount();
+        QThreadPool::globalInstance()->setMaxThreadCount(threads);
+        std::vector<SelfPlayTask> tasks;
+        const int games = std::max(1, parser.value(gamesOption).toInt());
+        for (int game = 0; game < games; ++game)
+            tasks.push_back(SelfPlayTask{ &variant, &engine, std::max(0, parser.value(openingOption).toInt()),
+                                          parser.value(randomOption).toDouble(),
+                                          seed * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(game) });
+        const QList<std::vector<Sample>> results = QtConcurrent::mapped(tasks, playSelfPlayGame).results();
+        for (const std::vector<Sample> &game : results)
+            samples.insert(samples.end(), game.begin(), game.end());
+        out << "Self-play: " << games << " games at depth " << engine.depth << ", " << samples.size()
+            << " positions in " << QString::number(timer.nsecsElapsed() / 1e9, 'f', 2) << " s\n";
+    }
+    if (samples.size() < 10)
+    {
+        err << "Not enough positions to train on.\n";
+        return 1;
+    }
+
+    // The last tenth is held out to check the network generalises.
+    std::mt19937_64 random(seed);
+    std::shuffle(samples.begin(), samples.end(), random);
+    const size_t trainSize = samples.size() - samples.size() / 10;
+    const int epochs = std::max(1, parser.value(epochsOption).toInt());
+    const float rate = parser.value(rateOption).toFloat();
+    std::vector<float> accumulator(2 * net.hidden());
+    out << variant.size << "x" << variant.size << " k=" << variant.k << ", " << net.hidden() << " hidden units, "
+        << trainSize << " training / " << samples.size() - trainSize << " validation positions\n";
+    for (int epoch = 1; epoch <= epochs; ++epoch)
+    {
+        std::shuffle(samples.begin(), samples.begin() + trainSize, random);
+        double trainLoss = 0.0;
+        for (size_t i = 0; i < trainSize; ++i)
+            trainLoss += trainSample(net, variant, samples[i], rate, accumulator);
+        double loss, accuracy;
+        measure(net, samples, trainSize, samples.size(), loss, accuracy);
+        out << "epoch " << epoch << ": train loss " << QString::number(trainLoss / trainSize, 'f', 4)
+            << ", validation loss " << QString::number(loss, 'f', 4) << ", accuracy "
+            << QString::number(accuracy, 'f', 1) << "%\n";
+        out.flush();
+    }
+
+    // Inference speed with the kernels this CPU selected.
+    timer.restart();
+    double loss, accuracy;
+    measure(net, samples, 0, samples.size(), loss, accuracy);
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    out << "Evaluated " << samples.size() << " positions with " << NeuralNet::kernelName() << " kernels: "
+        << QString::number(samples.size() / std::max(seconds, 1e-9), 'f', 0) << " positions/s\n";
+
+    if (!net.save(parser.value(outputOption).toStdString()))
+    {
+        err << "Cannot write " << parser.value(outputOption) << "\n";
+        return 1;
+    }
+    out << "Wrote " << parser.value(outputOption) << "\n";
+    return 0;
+}